@@ -28,70 +28,424 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include "board.h"
+#include "automata.h"
+#include "rule.h"
+#include "boundary.h"
+#include "simd.h"
 #include "omp.h"
 
 #define USE_OMP 1
 
-void increase(board_t board, int i, int* sum) {
-    if (i >= 0 && i < (board.size*board.size)) {
-        *sum += board.data[i];
+/*
+ * Block computed by one OpenMP task, a few rows wide enough to stream
+ * and small enough to stay in the L2 cache with its halo rows
+ */
+#define OMP_BLOCK_ROWS 32
+#define OMP_BLOCK_COLS 2048
+
+/*
+ * Calculate the next state of the cells (i, j0) to (i, j1) excluded
+ * The vertical sums of 3 columns slide along the row, the halo of the
+ * board gives the cells around it so the loop has no bound test
+ */
+static inline void lifeRowRange(const char* up, const char* mid, const char* down,
+                                char* out, int j0, int j1,
+                                unsigned birth, unsigned survival) {
+    int left = up[j0-1] + mid[j0-1] + down[j0-1];
+    int centre = up[j0] + mid[j0] + down[j0];
+
+    for (int j = j0; j < j1; j++) {
+        int right = up[j+1] + mid[j+1] + down[j+1];
+        int sum = left + centre + right - mid[j];
+        out[j] = ruleNext(mid[j], sum, birth, survival);
+        left = centre;
+        centre = right;
     }
 }
 
-void calculateStateOMP(board_t state, board_t newState) {
-    int i;
-    #pragma omp parallel for
-    for (i = 0; i < (state.size*state.size); ++i) {
-        int sum = 0;
-        increase(state, i-1, &sum);
-        increase(state, i+1, &sum);
-        for (int ii = i-state.size-1; ii <= (i-state.size+1); ++ii) { increase(state, ii, &sum); }
-        for (int ii = i+state.size-1; ii <= (i+state.size+1); ++ii) { increase(state, ii, &sum); }
-
-        if (sum == 3 || (state.data[i] == 1 && sum == 2)) {
-            newState.data[i] = 1;
-        } else {
-            newState.data[i] = 0;
-        }
+void calculateStateOMP(board_t state, board_t newState, changes_t* changes) {
+    int width = state.width;
+    int height = state.height;
+    int blocksI = (height + OMP_BLOCK_ROWS - 1) / OMP_BLOCK_ROWS;
+    int blocksJ = (width + OMP_BLOCK_COLS - 1) / OMP_BLOCK_COLS;
+    rule_t rule = getRule();
+    if (changes != NULL) {
+        clearChanges(changes);
     }
-}
 
-void calculateStateSeq(board_t state, board_t newState) {
-    int size = state.size;
-    for (int i = 0; i < size; i++) {
-        int c1 = 0, c2 = 0;
-        int c3 = (i > 0 ? state.data[idx(i-1, 0, size)] : 0) + state.data[idx(i, 0, size)] + (i+1 < size ? state.data[idx(i+1, 0, size)] : 0);
+    #pragma omp parallel for schedule(runtime)
+    for (int b = 0; b < blocksI * blocksJ; b++) {
+        int i0 = (b / blocksJ) * OMP_BLOCK_ROWS;
+        int j0 = (b % blocksJ) * OMP_BLOCK_COLS;
+        int i1 = (i0 + OMP_BLOCK_ROWS < height ? i0 + OMP_BLOCK_ROWS : height);
+        int j1 = (j0 + OMP_BLOCK_COLS < width ? j0 + OMP_BLOCK_COLS : width);
 
-        for (int j = 0; j < size; j++) {
-            c2 = c3 - state.data[idx(i, j, size)];
-            c3 = 0;
-            if (j+1 < size) {
-                for (int k = (i-1 > 0 ? i-1 : 0); k < (i+2 < size ? i+2 : size); k++) {
-                    c3 += state.data[idx(k, j+1, size)];
+        for (int i = i0; i < i1; i++) {
+            const char* up = &state.data[boardIdx(i-1, 0, width)];
+            const char* mid = &state.data[boardIdx(i, 0, width)];
+            const char* down = &state.data[boardIdx(i+1, 0, width)];
+            char* out = &newState.data[boardIdx(i, 0, width)];
+            // Dispatched inside the parallel region so each task gets the constant masks
+            #define OMP_ROW(B, S) lifeRowRange(up, mid, down, out, j0, j1, B, S)
+            RULE_SPECIALIZE(rule, OMP_ROW);
+            #undef OMP_ROW
+            if (changes != NULL) {
+                // The blocks of a row share a word of tiles (OMP_BLOCK_COLS divides 64 tiles)
+                uint64_t bits = changedCells(mid, out, j0, j1);
+                if (bits != 0) {
+                    #pragma omp atomic
+                    changedRow(changes, i)[j0 / (64 * CHANGE_TILE)] |= bits;
                 }
             }
+        }
+    }
+}
+
+void calculateStateSeq(board_t state, board_t newState, changes_t* changes) {
+    int width = state.width;
+    rule_t rule = getRule();
+    for (int i = 0; i < state.height; i++) {
+        const char* up = &state.data[boardIdx(i-1, 0, width)];
+        const char* mid = &state.data[boardIdx(i, 0, width)];
+        const char* down = &state.data[boardIdx(i+1, 0, width)];
+        int c1 = up[-1] + mid[-1] + down[-1], c2 = 0;
+        int c3 = up[0] + mid[0] + down[0];
+
+        for (int j = 0; j < width; j++) {
+            c2 = c3 - mid[j];
+            c3 = up[j+1] + mid[j+1] + down[j+1];
 
             int nbrCell = c1 + c2 + c3;
-            if (nbrCell == 3 || (state.data[idx(i, j, size)] == 1 && nbrCell == 2)) {
-                newState.data[idx(i, j, size)] = 1;
+            if (mid[j] == 1) {
+                newState.data[boardIdx(i, j, width)] = (rule.survival >> nbrCell) & 1;
             } else {
-                newState.data[idx(i, j, size)] = 0;
+                newState.data[boardIdx(i, j, width)] = (rule.birth >> nbrCell) & 1;
+            }
+
+            c1 = c2 + mid[j];
+        }
+        if (changes != NULL) {
+            markCharRow(changes, i, mid, &newState.data[boardIdx(i, 0, width)], width);
+        }
+    }
+}
+
+/*
+ * Next state of the word C of a row, given the words before (P) and after (N)
+ * of the row and of the rows above and below
+ */
+static inline uint64_t lifeWordAt(uint64_t upP, uint64_t upC, uint64_t upN,
+                                  uint64_t midP, uint64_t midC, uint64_t midN,
+                                  uint64_t downP, uint64_t downC, uint64_t downN,
+                                  unsigned birth, unsigned survival) {
+    // Bit b is cell 64*k+b, so the west neighbour comes from a left shift
+    return lifeWordRule((upC << 1) | (upP >> 63), upC, (upC >> 1) | (upN << 63),
+                        (midC << 1) | (midP >> 63), midC, (midC >> 1) | (midN << 63),
+                        (downC << 1) | (downP >> 63), downC, (downC >> 1) | (downN << 63),
+                        birth, survival);
+}
+
+/*
+ * Next state of a single row of a bit-packed board
+ * The ghost cells of the boundary stand for the words around the row, the
+ * last word is computed apart so the loop over the words has no test
+ * The bit k of changed is set when the word k changed, unless it is NULL
+ */
+static inline void lifeRow(const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                           uint64_t* out, int width, int words, uint64_t lastMask, int boundary,
+                           uint64_t* changed, unsigned birth, unsigned survival) {
+    ghost_t gu = packedGhost(up, width, boundary);
+    ghost_t gm = packedGhost(mid, width, boundary);
+    ghost_t gd = packedGhost(down, width, boundary);
+    uint64_t upP = gu.west, midP = gm.west, downP = gd.west;
+    uint64_t upC = up[0], midC = mid[0], downC = down[0];
+    uint64_t bits = 0;
+
+    for (int k = 0; k+1 < words; k++) {
+        uint64_t upN = up[k+1], midN = mid[k+1], downN = down[k+1];
+        uint64_t word = lifeWordAt(upP, upC, upN, midP, midC, midN, downP, downC, downN, birth, survival);
+        out[k] = word;
+        bits |= (uint64_t)(word != midC) << (k % 64);
+        if (changed != NULL && k % 64 == 63) {
+            changed[k / 64] = bits;
+            bits = 0;
+        }
+
+        upP = upC; midP = midC; downP = downC;
+        upC = upN; midC = midN; downC = downN;
+    }
+    uint64_t last = lifeWordAt(upP, upC | gu.pad, gu.next, midP, midC | gm.pad, gm.next,
+                               downP, downC | gd.pad, gd.next, birth, survival) & lastMask;
+    out[words-1] = last;
+    if (changed != NULL) {
+        changed[(words-1) / 64] = bits | (uint64_t)(last != midC) << ((words-1) % 64);
+    }
+}
+
+/*
+ * Mask of the cells that exist in the last word of a row
+ */
+static inline uint64_t lastWordMask(int width) {
+    return (width % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (width % 64)) - 1);
+}
+
+/*
+ * Calculate the rows i0 to i1 (excluded) of a bit-packed board, and the changed
+ * tiles of each row unless changes is NULL
+ */
+static void calculateRowsChanged(packed_board_t state, packed_board_t newState, int i0, int i1,
+                                 changes_t* changes) {
+    int width = state.width;
+    int words = state.words;
+    uint64_t lastMask = lastWordMask(width);
+    rule_t rule = getRule();
+    int boundary = getBoundary();
+
+    #pragma omp parallel for
+    for (int i = i0; i < i1; i++) {
+        uint64_t* changed = (changes != NULL ? changedRow(changes, i) : NULL);
+        #define PACKED_ROW(B, S) lifeRow(packedRow(state, i-1), packedRow(state, i), packedRow(state, i+1), \
+                                         packedRow(newState, i), width, words, lastMask, boundary, changed, B, S)
+        RULE_SPECIALIZE(rule, PACKED_ROW);
+        #undef PACKED_ROW
+    }
+}
+
+/**
+ * Calculate the next state of the rows i0 to i1 (excluded) of a bit-packed board
+ * The halo rows of state must have been filled, with fillPackedHalo or by the
+ * strips around it (see distrib.h)
+ */
+void calculateRowsPacked(packed_board_t state, packed_board_t newState, int i0, int i1) {
+    calculateRowsChanged(state, newState, i0, i1, NULL);
+}
+
+/**
+ * Calculate the next state of a bit-packed board, 64 cells per operation
+ * The rule is the one selected by setRule, the halo rows are filled for the boundary
+ */
+void calculateStatePacked(packed_board_t state, packed_board_t newState, changes_t* changes) {
+    fillPackedHalo(state);
+    calculateRowsChanged(state, newState, 0, state.height, changes);
+}
+
+typedef void (*kernel_fn)(board_t state, board_t newState, changes_t* changes);
+
+static const char* kernelNames[KERNEL_COUNT] = { "seq", "omp", "sse2", "avx2", "avx512" };
+static const kernel_fn kernels[KERNEL_COUNT] = {
+    calculateStateSeq, calculateStateOMP, calculateStateSSE2, calculateStateAVX2, calculateStateAVX512
+};
+static int currentKernel = -1;
+
+/**
+ * Return 1 if the kernel can run on this host
+ */
+int kernelSupported(int kernel) {
+    switch (kernel) {
+        case KERNEL_SEQ:
+            return 1;
+        case KERNEL_OMP:
+            #if defined(_OPENMP) && USE_OMP == 1
+                return 1;
+            #else
+                return 0;
+            #endif
+        case KERNEL_SSE2:
+            return sse2Supported();
+        case KERNEL_AVX2:
+            return avx2Supported();
+        case KERNEL_AVX512:
+            return avx512Supported();
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Return the name of a kernel
+ */
+const char* kernelName(int kernel) {
+    return kernelNames[kernel];
+}
+
+/**
+ * Set the OpenMP schedule of the omp kernel : static, dynamic or guided,
+ * optionally followed by a chunk size ("dynamic,4")
+ * Return 0 if the schedule is invalid
+ */
+int setSchedule(const char* spec) {
+    char kind[16];
+    int chunk = 0;
+    if (sscanf(spec, "%15[a-z],%d", kind, &chunk) < 1 || chunk < 0) {
+        return 0;
+    }
+
+    if (!strcmp(kind, "static")) {
+        omp_set_schedule(omp_sched_static, chunk);
+    } else if (!strcmp(kind, "dynamic")) {
+        omp_set_schedule(omp_sched_dynamic, chunk);
+    } else if (!strcmp(kind, "guided")) {
+        omp_set_schedule(omp_sched_guided, chunk);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Run the kernel and the sequential kernel side by side on copies of the board
+ * Return the first generation where the boards differ, 0 if they are identical
+ */
+int checkKernel(board_t board, int kernel, int generations) {
+    int width = board.width;
+    board_t ref = allocBoard(width, board.height), refNext = allocBoard(width, board.height);
+    board_t curr = allocBoard(width, board.height), next = allocBoard(width, board.height);
+    copyBoard(board, ref);
+    copyBoard(board, curr);
+
+    int mismatch = 0;
+    for (int g = 1; g <= generations && !mismatch; g++) {
+        fillHalo(ref);
+        fillHalo(curr);
+        calculateStateSeq(ref, refNext, NULL);
+        kernels[kernel](curr, next, NULL);
+        for (int i = 0; i < board.height && !mismatch; i++) {
+            if (memcmp(&refNext.data[boardIdx(i, 0, width)], &next.data[boardIdx(i, 0, width)], width)) {
+                mismatch = g;
             }
+        }
+
+        board_t tmp = ref;
+        ref = refNext;
+        refNext = tmp;
+        tmp = curr;
+        curr = next;
+        next = tmp;
+    }
+
+    freeBoard(ref);
+    freeBoard(refNext);
+    freeBoard(curr);
+    freeBoard(next);
+    return mismatch;
+}
 
-            c1 = c2 + state.data[idx(i, j, size)];
+/**
+ * Select the kernel used by calculateState, by name or "auto"
+ * "auto" picks the widest vector kernel supported by the CPU
+ * Return 0 if the kernel is unknown or unsupported
+ */
+int selectKernel(const char* name) {
+    if (!strcmp(name, "auto")) {
+        currentKernel = KERNEL_SEQ;
+        for (int k = KERNEL_SSE2; k < KERNEL_COUNT; k++) {
+            if (kernelSupported(k)) {
+                currentKernel = k;
+            }
         }
+        return 1;
     }
+
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (!strcmp(name, kernelNames[k]) && kernelSupported(k)) {
+            currentKernel = k;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Return the kernel used by calculateState
+ */
+int getKernel() {
+    if (currentKernel < 0) {
+        selectKernel("auto");
+    }
+    return currentKernel;
+}
+
+/*
+ * Next state of the active words of a row, the differences are accumulated in changed and unstable
+ */
+static inline void lifeRowActive(const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                                 uint64_t* out, int width, int words, uint64_t lastMask, int boundary,
+                                 const char* active, uint64_t* changed, uint64_t* unstable,
+                                 unsigned birth, unsigned survival) {
+    ghost_t gu = packedGhost(up, width, boundary);
+    ghost_t gm = packedGhost(mid, width, boundary);
+    ghost_t gd = packedGhost(down, width, boundary);
+    uint64_t upP = gu.west, midP = gm.west, downP = gd.west;
+    uint64_t upC = up[0], midC = mid[0], downC = down[0];
+
+    for (int k = 0; k < words; k++) {
+        uint64_t upN = gu.next, midN = gm.next, downN = gd.next;
+        uint64_t word = 0;
+        if (k+1 < words) {
+            upN = up[k+1];
+            midN = mid[k+1];
+            downN = down[k+1];
+            if (active[k]) {
+                word = lifeWordAt(upP, upC, upN, midP, midC, midN, downP, downC, downN, birth, survival);
+            }
+        } else if (active[k]) {
+            word = lifeWordAt(upP, upC | gu.pad, upN, midP, midC | gm.pad, midN,
+                              downP, downC | gd.pad, downN, birth, survival) & lastMask;
+        }
+
+        if (active[k]) {
+            changed[k] |= word ^ midC;
+            unstable[k] |= word ^ out[k];
+            out[k] = word;
+        }
+
+        upP = upC; midP = midC; downP = downC;
+        upC = upN; midC = midN; downC = downN;
+    }
+}
+
+/**
+ * Calculate the next state of the rows i0 to i1 (excluded), only for the words k with active[k] set
+ * TILE_CHANGED is added to flags[k] if a cell differs from the current state, and
+ * TILE_UNSTABLE if a cell differs from the previous content of newState (two generations ago)
+ * The halo rows of state must have been filled with fillPackedHalo
+ */
+void calculateBandPacked(packed_board_t state, packed_board_t newState, int i0, int i1,
+                         const char* active, char* flags) {
+    int words = state.words;
+    uint64_t lastMask = lastWordMask(state.width);
+    uint64_t* changed = calloc(sizeof(uint64_t), 2 * (size_t)words);
+    uint64_t* unstable = changed + words;
+    rule_t rule = getRule();
+    int boundary = getBoundary();
+    assert(changed != NULL);
+
+    for (int i = i0; i < i1; i++) {
+        #define BAND_ROW(B, S) lifeRowActive(packedRow(state, i-1), packedRow(state, i), packedRow(state, i+1), \
+                                             packedRow(newState, i), state.width, words, lastMask, boundary, \
+                                             active, changed, unstable, B, S)
+        RULE_SPECIALIZE(rule, BAND_ROW);
+        #undef BAND_ROW
+    }
+
+    for (int k = 0; k < words; k++) {
+        flags[k] |= (changed[k] != 0 ? TILE_CHANGED : 0) | (unstable[k] != 0 ? TILE_UNSTABLE : 0);
+    }
+    free(changed);
 }
 
 /**
  * Calculate the next state of the life game
- * Rules : 3 -> born, 2-3 -> survive, else -> die
- */
-void calculateState(board_t state, board_t newState) {
-    #if defined(_OPENMP) && USE_OMP == 1
-        calculateStateOMP(state, newState);
-    #else
-        calculateStateSeq(state, newState);
-    #endif
+ * The rule is the one selected by setRule (Conway's B3/S23 by default), the
+ * halo of the board is filled for the boundary selected by setBoundary
+ */
+void calculateState(board_t state, board_t newState, changes_t* changes) {
+    fillHalo(state);
+    kernels[getKernel()](state, newState, changes);
 }
@@ -31,6 +31,149 @@ SOFTWARE.
 #ifndef _AUTOMATA_H_
 #define _AUTOMATA_H_
 
-void calculateState(board_t state, board_t newState);
+#include <stdint.h>
+#include "board.h"
+#include "rule.h"
+
+#define KERNEL_SEQ 0
+#define KERNEL_OMP 1
+#define KERNEL_SSE2 2
+#define KERNEL_AVX2 3
+#define KERNEL_AVX512 4
+#define KERNEL_COUNT 5
+
+/**
+ * Calculate the next state of the life game with the selected kernel
+ * The halo of state is filled for the boundary first, the changed tiles are
+ * written to changes unless it is NULL
+ */
+void calculateState(board_t state, board_t newState, changes_t* changes);
+
+/**
+ * Return 1 if the kernel can run on this host
+ */
+int kernelSupported(int kernel);
+/**
+ * Return the name of a kernel
+ */
+const char* kernelName(int kernel);
+/**
+ * Set the OpenMP schedule of the omp kernel : static, dynamic or guided,
+ * optionally followed by a chunk size ("dynamic,4")
+ * Return 0 if the schedule is invalid
+ */
+int setSchedule(const char* spec);
+/**
+ * Run the kernel and the sequential kernel side by side on copies of the board
+ * Return the first generation where the boards differ, 0 if they are identical
+ */
+int checkKernel(board_t board, int kernel, int generations);
+/**
+ * Select the kernel used by calculateState, by name or "auto"
+ * "auto" picks the widest vector kernel supported by the CPU
+ * Return 0 if the kernel is unknown or unsupported
+ */
+int selectKernel(const char* name);
+/**
+ * Return the kernel used by calculateState
+ */
+int getKernel();
+
+/**
+ * Next state of 64 cells given the 8 neighbour words and the current word
+ * The neighbour count is summed bit-sliced with full adders : ones, twos
+ * and fours hold the bits of the count for the 64 cells at once
+ */
+static inline uint64_t lifeWord(uint64_t nw, uint64_t n, uint64_t ne,
+                                uint64_t w, uint64_t cell, uint64_t e,
+                                uint64_t sw, uint64_t s, uint64_t se) {
+    // Upper and lower rows : 3 bits into (sum, carry)
+    uint64_t upS = nw ^ n ^ ne;
+    uint64_t upC = (nw & n) | (ne & (nw ^ n));
+    uint64_t loS = sw ^ s ^ se;
+    uint64_t loC = (sw & s) | (se & (sw ^ s));
+    // Middle row : 2 bits
+    uint64_t miS = w ^ e;
+    uint64_t miC = w & e;
+
+    uint64_t ones = upS ^ loS ^ miS;
+    uint64_t onesC = (upS & loS) | (miS & (upS ^ loS));
+
+    uint64_t twosA = upC ^ loC;
+    uint64_t twosB = miC ^ onesC;
+    uint64_t twos = twosA ^ twosB;
+    uint64_t fours = (upC & loC) | (miC & onesC) | (twosA & twosB);
+
+    // Alive with 3 neighbours, or 2 neighbours and already alive
+    return ~fours & twos & (ones | cell);
+}
+
+/**
+ * Next state of 64 cells for any rule given by its birth and survival masks
+ * Conway's rule uses lifeWord, the other ones need the exact count : the carries
+ * into the fours are added instead of saturated, giving the fours and eights bits
+ * With constant masks the tests of the counts are resolved at compile time
+ */
+static inline uint64_t lifeWordRule(uint64_t nw, uint64_t n, uint64_t ne,
+                                    uint64_t w, uint64_t cell, uint64_t e,
+                                    uint64_t sw, uint64_t s, uint64_t se,
+                                    unsigned birth, unsigned survival) {
+    if (birth == RULE_CONWAY_BIRTH && survival == RULE_CONWAY_SURVIVAL) {
+        return lifeWord(nw, n, ne, w, cell, e, sw, s, se);
+    }
+
+    uint64_t upS = nw ^ n ^ ne;
+    uint64_t upC = (nw & n) | (ne & (nw ^ n));
+    uint64_t loS = sw ^ s ^ se;
+    uint64_t loC = (sw & s) | (se & (sw ^ s));
+    uint64_t miS = w ^ e;
+    uint64_t miC = w & e;
+
+    uint64_t ones = upS ^ loS ^ miS;
+    uint64_t onesC = (upS & loS) | (miS & (upS ^ loS));
+
+    uint64_t twosA = upC ^ loC;
+    uint64_t twosB = miC ^ onesC;
+    uint64_t twos = twosA ^ twosB;
+    uint64_t c1 = upC & loC, c2 = miC & onesC, c3 = twosA & twosB;
+    uint64_t fours = c1 ^ c2 ^ c3;
+    uint64_t eights = (c1 & c2) | (c3 & (c1 ^ c2));
+
+    uint64_t born = 0, survive = 0;
+    for (int count = 0; count <= 8; count++) {
+        uint64_t equal = ((count & 1) ? ones : ~ones) & ((count & 2) ? twos : ~twos)
+                       & ((count & 4) ? fours : ~fours) & ((count & 8) ? eights : ~eights);
+        if ((birth >> count) & 1) {
+            born |= equal;
+        }
+        if ((survival >> count) & 1) {
+            survive |= equal;
+        }
+    }
+    return (born & ~cell) | (survive & cell);
+}
+
+/**
+ * Calculate the next state of a bit-packed board, 64 cells per operation
+ * The changed tiles are written to changes unless it is NULL
+ */
+void calculateStatePacked(packed_board_t state, packed_board_t newState, changes_t* changes);
+/**
+ * Calculate the next state of the rows i0 to i1 (excluded) of a bit-packed board
+ * The halo rows of state must have been filled, with fillPackedHalo or by the
+ * strips around it (see distrib.h)
+ */
+void calculateRowsPacked(packed_board_t state, packed_board_t newState, int i0, int i1);
+#define TILE_CHANGED 1
+#define TILE_UNSTABLE 2
+
+/**
+ * Calculate the next state of the rows i0 to i1 (excluded), only for the words k with active[k] set
+ * TILE_CHANGED is added to flags[k] if a cell differs from the current state, and
+ * TILE_UNSTABLE if a cell differs from the previous content of newState (two generations ago)
+ * The halo rows of state must have been filled with fillPackedHalo
+ */
+void calculateBandPacked(packed_board_t state, packed_board_t newState, int i0, int i1,
+                         const char* active, char* flags);
 
 #endif
\ No newline at end of file
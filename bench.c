@@ -0,0 +1,145 @@
+/*
+ * Title    : Game of life / bench
+ * Desc     : Benchmark suite : clock, latency statistics and JSON or CSV reports
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "omp.h"
+#include "bench.h"
+#include "rule.h"
+
+/*
+ * Return the time of a monotonic clock in ms
+ */
+double benchClock(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1e+3 + t.tv_nsec*1e-6;
+}
+
+/*
+ * Set the number of OpenMP threads, return the number available
+ */
+int benchThreads(int threads) {
+    int available = omp_get_num_procs();
+    if (threads > 0) {
+        omp_set_num_threads(threads);
+    }
+    return available;
+}
+
+/*
+ * Compare two latencies for qsort
+ */
+static int compareSamples(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Return the p-th percentile of sorted samples, nearest rank
+ */
+static double percentile(const double* samples, int count, int p) {
+    int rank = (p * count + 99) / 100;
+    return samples[(rank < 1 ? 1 : rank) - 1];
+}
+
+/*
+ * Compute the statistics of a result from the latencies of its generations
+ * The samples are sorted in place, generations is left to the caller
+ */
+void benchStats(bench_result_t* result, double* samples, int count) {
+    qsort(samples, count, sizeof(double), compareSamples);
+
+    double total = 0;
+    for (int k = 0; k < count; k++) {
+        total += samples[k];
+    }
+    result->median = percentile(samples, count, 50);
+    result->p95 = percentile(samples, count, 95);
+    result->p99 = percentile(samples, count, 99);
+    result->mean = total / count;
+    result->cellsPerSecond = (double)result->width * result->height / (result->mean * 1e-3);
+}
+
+/*
+ * Write the results as a JSON document
+ */
+static void writeJson(FILE* file, const bench_result_t* results, int count) {
+    char rule[RULE_LENGTH];
+    formatRule(getRule(), rule, sizeof(rule));
+    fprintf(file, "{\n  \"seed\": %d,\n  \"rule\": \"%s\",\n  \"compiler\": \"%s\",\n  \"processors\": %d,\n  \"results\": [\n",
+            BENCH_SEED, rule, __VERSION__, benchThreads(0));
+    for (int k = 0; k < count; k++) {
+        const bench_result_t* r = &results[k];
+        fprintf(file, "    {\"engine\": \"%s\", \"kernel\": \"%s\", \"width\": %d, \"height\": %d, \"density\": %.2f, \"threads\": %d, "
+                      "\"warmup\": %d, \"generations\": %d, \"median_ms\": %.6f, \"p95_ms\": %.6f, \"p99_ms\": %.6f, "
+                      "\"mean_ms\": %.6f, \"cells_per_second\": %.0f}%s\n",
+                r->engine, r->kernel, r->width, r->height, r->density, r->threads, r->warmup, r->generations,
+                r->median, r->p95, r->p99, r->mean, r->cellsPerSecond, (k + 1 < count ? "," : ""));
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+/*
+ * Write the results as CSV, one line per configuration
+ */
+static void writeCsv(FILE* file, const bench_result_t* results, int count) {
+    fprintf(file, "engine,kernel,width,height,density,threads,warmup,generations,median_ms,p95_ms,p99_ms,mean_ms,cells_per_second\n");
+    for (int k = 0; k < count; k++) {
+        const bench_result_t* r = &results[k];
+        fprintf(file, "%s,%s,%d,%d,%.2f,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.0f\n",
+                r->engine, r->kernel, r->width, r->height, r->density, r->threads, r->warmup, r->generations,
+                r->median, r->p95, r->p99, r->mean, r->cellsPerSecond);
+    }
+}
+
+/*
+ * Write the results to a file, JSON or CSV given by the extension
+ */
+void writeBenchResults(const char* filename, const bench_result_t* results, int count) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t length = strlen(filename);
+    if (length > 4 && !strcmp(&filename[length - 4], ".csv")) {
+        writeCsv(file, results, count);
+    } else {
+        writeJson(file, results, count);
+    }
+    fclose(file);
+}
@@ -0,0 +1,77 @@
+/*
+ * Title    : Game of life / bench
+ * Desc     : Headers for the benchmark suite
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#define BENCH_SEED 20220801
+
+/*
+ * Measures of one configuration, the latencies are per generation in ms
+ * The warmup generations are run first and not measured
+ */
+typedef struct bench_result {
+    const char* engine;
+    const char* kernel;
+    int width;
+    int height;
+    double density;
+    int threads;
+    int warmup;
+    int generations;
+    double median;
+    double p95;
+    double p99;
+    double mean;
+    double cellsPerSecond;
+} bench_result_t;
+
+/*
+ * Return the time of a monotonic clock in ms
+ */
+double benchClock(void);
+
+/*
+ * Set the number of OpenMP threads, return the number available
+ */
+int benchThreads(int threads);
+
+/*
+ * Compute the statistics of a result from the latencies of its generations
+ * The samples are sorted in place, generations is left to the caller
+ */
+void benchStats(bench_result_t* result, double* samples, int count);
+
+/*
+ * Write the results to a file, JSON or CSV given by the extension
+ */
+void writeBenchResults(const char* filename, const bench_result_t* results, int count);
+
+#endif
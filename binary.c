@@ -0,0 +1,269 @@
+/*
+ * Title    : Game of life / binary
+ * Desc     : Binary board files, memory mapped on load
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "board.h"
+#include "binary.h"
+#include "rule.h"
+#include "pattern.h"
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL
+#define CHECKSUM_PRIME 0x100000001b3ULL
+
+// The board starts 8-byte aligned after the header
+_Static_assert(sizeof(binary_header_t) == 128, "binary header must be 128 bytes");
+
+/*
+ * Print an error about a binary board file and exit
+ */
+static void binaryError(const char* filename, const char* msg) {
+    fprintf(stderr, "%s: %s\n", filename, msg);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * Return 1 if the file is a binary board (.lgb extension or magic number)
+ */
+int isBinaryBoard(const char* filename) {
+    char magic[8] = "";
+    int length = 0;
+    FILE* file = fopen(filename, "rb");
+    if (file != NULL) {
+        length = fread(magic, 1, sizeof(magic), file);
+        fclose(file);
+    }
+
+    return patternFormat(filename, magic, length) == FORMAT_BINARY;
+}
+
+/*
+ * Return the checksum of the cells of a bit-packed board
+ * FNV-1a on 64-bit words, the halo rows are not included
+ */
+uint64_t packedChecksum(packed_board_t board) {
+    uint64_t checksum = CHECKSUM_SEED;
+    const uint64_t* data = packedRow(board, 0);
+    size_t length = (size_t)board.height * board.words;
+
+    for (size_t k = 0; k < length; k++) {
+        checksum = (checksum ^ data[k]) * CHECKSUM_PRIME;
+    }
+    return checksum;
+}
+
+/*
+ * Map a binary board file in memory, the returned board uses the file pages
+ * without copy (private mapping, so the engines can write to it)
+ * Free it with freePackedBoard
+ */
+packed_board_t mapBinaryBoard(const char* filename, binary_header_t* header) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        binaryError(filename, strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(binary_header_t)) {
+        binaryError(filename, "not a binary board");
+    }
+
+    size_t length = st.st_size;
+    char* mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        binaryError(filename, strerror(errno));
+    }
+
+    memcpy(header, mapping, sizeof(binary_header_t));
+    if (memcmp(header->magic, BINARY_MAGIC, sizeof(header->magic))
+            || header->version < 1 || header->version > BINARY_VERSION) {
+        binaryError(filename, "not a binary board, or unsupported version");
+    }
+    if (header->version == 1) {
+        header->height = header->width;
+    }
+    if (header->width < 1 || header->width > INT32_MAX || header->words != (header->width + 63) / 64
+            || header->height < 1 || header->height > INT32_MAX - 2
+            || length != sizeof(binary_header_t) + (size_t)(header->height + 2) * header->words * sizeof(uint64_t)) {
+        binaryError(filename, "truncated or inconsistent binary board");
+    }
+
+    packed_board_t board;
+    board.width = header->width;
+    board.height = header->height;
+    board.words = header->words;
+    board.data = (uint64_t*)(mapping + sizeof(binary_header_t));
+    board.mapping = mapping;
+    board.mappingLength = length;
+
+    if (packedChecksum(board) != header->checksum) {
+        binaryError(filename, "checksum mismatch");
+    }
+
+    // The board continues with the rule it was saved with
+    rule_t rule;
+    header->rule[BINARY_RULE_LENGTH-1] = '\0';
+    if (!parseRule(header->rule, &rule)) {
+        binaryError(filename, "unsupported rule");
+    }
+    setRule(rule);
+
+    return board;
+}
+
+/*
+ * Return the header of a board, without its checksum
+ */
+static binary_header_t binaryHeader(int width, int height, long long generation) {
+    binary_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.width = width;
+    header.words = (width + 63) / 64;
+    header.height = height;
+    header.generation = generation;
+    formatRule(getRule(), header.rule, BINARY_RULE_LENGTH);
+    return header;
+}
+
+/*
+ * Write a bit-packed board and its generation to a binary board file
+ * The header, the rows and the zero rows around them go out in a single writev,
+ * the halo rows of the board hold boundary cells which aren't saved
+ */
+void writeBinaryBoard(packed_board_t board, long long generation, const char* filename) {
+    binary_header_t header = binaryHeader(board.width, board.height, generation);
+    header.checksum = packedChecksum(board);
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        binaryError(filename, strerror(errno));
+    }
+
+    size_t row = (size_t)board.words * sizeof(uint64_t);
+    uint64_t* zero = calloc(board.words, sizeof(uint64_t));
+    assert(zero != NULL);
+    struct iovec iov[4] = {
+        { &header, sizeof(header) },
+        { zero, row },
+        { packedRow(board, 0), (size_t)board.height * row },
+        { zero, row }
+    };
+    while (iov[3].iov_len > 0) {
+        ssize_t n = writev(fd, iov, 4);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            binaryError(filename, strerror(errno));
+        }
+        // Partial write, skip what is already written
+        for (int k = 0; k < 4; k++) {
+            size_t done = ((size_t)n < iov[k].iov_len ? (size_t)n : iov[k].iov_len);
+            iov[k].iov_base = (char*)iov[k].iov_base + done;
+            iov[k].iov_len -= done;
+            n -= done;
+        }
+    }
+
+    free(zero);
+    close(fd);
+}
+
+/*
+ * Create a binary board file of width x height cells, its rows are then given
+ * in order with writeBinaryRows
+ * The header is written again when the file is closed, with the checksum
+ */
+binary_writer_t beginBinaryBoard(int width, int height, long long generation, const char* filename) {
+    binary_writer_t writer;
+    writer.filename = filename;
+    writer.header = binaryHeader(width, height, generation);
+    writer.header.checksum = CHECKSUM_SEED;
+    writer.rows = 0;
+    writer.file = fopen(filename, "wb");
+    if (writer.file == NULL) {
+        binaryError(filename, strerror(errno));
+    }
+
+    // The zero row above the board
+    uint64_t zero = 0;
+    fwrite(&writer.header, sizeof(binary_header_t), 1, writer.file);
+    for (uint32_t k = 0; k < writer.header.words; k++) {
+        fwrite(&zero, sizeof(uint64_t), 1, writer.file);
+    }
+    return writer;
+}
+
+/*
+ * Append count rows of words to a binary board file
+ */
+void writeBinaryRows(binary_writer_t* writer, const uint64_t* rows, int count) {
+    size_t length = (size_t)count * writer->header.words;
+    uint64_t checksum = writer->header.checksum;
+    for (size_t k = 0; k < length; k++) {
+        checksum = (checksum ^ rows[k]) * CHECKSUM_PRIME;
+    }
+    writer->header.checksum = checksum;
+    writer->rows += count;
+
+    if (fwrite(rows, sizeof(uint64_t), length, writer->file) != length) {
+        binaryError(writer->filename, strerror(errno));
+    }
+}
+
+/*
+ * Write the header with the checksum and close a binary board file
+ */
+void endBinaryBoard(binary_writer_t* writer) {
+    assert(writer->rows == (int)writer->header.height);
+
+    // The zero row below the board
+    uint64_t zero = 0;
+    for (uint32_t k = 0; k < writer->header.words; k++) {
+        fwrite(&zero, sizeof(uint64_t), 1, writer->file);
+    }
+    if (fseek(writer->file, 0, SEEK_SET) < 0
+            || fwrite(&writer->header, sizeof(binary_header_t), 1, writer->file) != 1
+            || fclose(writer->file) != 0) {
+        binaryError(writer->filename, strerror(errno));
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Title    : Game of life / binary
+ * Desc     : Headers for the binary board files
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _BINARY_H_
+#define _BINARY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "board.h"
+
+#define BINARY_MAGIC "LIFEGAME"
+#define BINARY_VERSION 2
+#define BINARY_RULE_LENGTH 32
+
+/*
+ * Header of a binary board file, followed by the bit-packed board exactly as
+ * packed_board_t stores it : (height + 2) rows of words, the halo rows above
+ * and below the board written as zero rows whatever the boundary
+ * The integers are in the byte order of the machine which wrote the file
+ * Version 1 files are square, their height field is zero
+ */
+typedef struct binary_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t words;
+    uint32_t height;
+    int64_t generation;
+    char rule[BINARY_RULE_LENGTH];
+    uint64_t checksum;
+    char padding[56];
+} binary_header_t;
+
+/*
+ * Binary board file written a few rows at a time, so the whole board never has
+ * to be in memory : the checksum is computed on the way and the header is
+ * completed when the file is closed
+ */
+typedef struct binary_writer {
+    FILE* file;
+    const char* filename;
+    binary_header_t header;
+    int rows;
+} binary_writer_t;
+
+/*
+ * Return 1 if the file is a binary board (.lgb extension or magic number)
+ */
+int isBinaryBoard(const char* filename);
+
+/*
+ * Return the checksum of the cells of a bit-packed board
+ */
+uint64_t packedChecksum(packed_board_t board);
+
+/*
+ * Map a binary board file in memory, the returned board uses the file pages
+ * without copy (private mapping, so the engines can write to it)
+ * The rule of the file is selected with setRule
+ * Free it with freePackedBoard
+ */
+packed_board_t mapBinaryBoard(const char* filename, binary_header_t* header);
+
+/*
+ * Write a bit-packed board and its generation to a binary board file
+ */
+void writeBinaryBoard(packed_board_t board, long long generation, const char* filename);
+
+/*
+ * Create a binary board file of width x height cells, its rows are then given
+ * in order with writeBinaryRows
+ */
+binary_writer_t beginBinaryBoard(int width, int height, long long generation, const char* filename);
+
+/*
+ * Append count rows of words to a binary board file
+ */
+void writeBinaryRows(binary_writer_t* writer, const uint64_t* rows, int count);
+
+/*
+ * Write the header with the checksum and close a binary board file
+ */
+void endBinaryBoard(binary_writer_t* writer);
+
+#endif
@@ -28,14 +28,18 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <sys/mman.h>
 #include "board.h"
-
-#define MIN_SIZE 3
+#include "pattern.h"
+#include "binary.h"
+#include "math.h"
 
 /*
  * Return the corresponding index in the flattened 2d-array
@@ -45,13 +49,15 @@ int idx(int i, int j, int size) {
 }
 
 /*
- * Alocate memory for a board of size (size x size)
+ * Alocate memory for a board of width x height cells and its halo
  */
-board_t allocBoard(int size) {
+board_t allocBoard(int width, int height) {
     board_t board;
-    board.size = size;
-    board.data = calloc(sizeof(char), size * size);
-    assert(board.data != NULL);
+    board.width = width;
+    board.height = height;
+    char* halo = calloc(sizeof(char), (size_t)(width + 2) * (height + 2));
+    assert(halo != NULL);
+    board.data = halo - boardIdx(-1, -1, width);
     
     return board;
 }
@@ -60,103 +66,347 @@ board_t allocBoard(int size) {
  * Free memory of a board
  */
 void freeBoard(board_t board) {
-    free(board.data);
+    if (board.data != NULL) {
+        free(board.data + boardIdx(-1, -1, board.width));
+    }
 }
 
 /*
- * Generate the board with the given file
- * Board size can be given, 0 to doesn't set it
+ * Copy the cells of a board into another board of the same dimensions, halo included
  */
-board_t getBoard(char* filename, int* size) {
-    board_t board;
+void copyBoard(board_t src, board_t dst) {
+    assert(src.width == dst.width && src.height == dst.height);
+    memcpy(dst.data + boardIdx(-1, -1, dst.width), src.data + boardIdx(-1, -1, src.width),
+           (size_t)(src.width + 2) * (src.height + 2));
+}
 
-    if (strcmp(filename, "")) {
-        FILE* file = fopen(filename, "r");
-        assert(file != NULL);
+/*
+ * Kill every cell of a board
+ */
+void clearBoard(board_t board) {
+    memset(board.data + boardIdx(-1, -1, board.width), 0, (size_t)(board.width + 2) * (board.height + 2));
+}
+
+/*
+ * Return the number of living cells of a board
+ */
+long long boardPopulation(board_t board) {
+    long long population = 0;
 
-        // Get size from the first line
-        char line[10];
-        if (fgets(line, 10, file) != NULL) {
-            line[strlen(line)-1] = 0;
+    #pragma omp parallel for reduction(+:population)
+    for (int i = 0; i < board.height; i++) {
+        const char* row = &board.data[boardIdx(i, 0, board.width)];
+        for (int j = 0; j < board.width; j++) {
+            population += row[j];
+        }
+    }
 
-            if (*size == 0) {
-                *size = atoi(line);
+    return population;
+}
+
+/*
+ * Alocate memory for a bit-packed board of width x height cells
+ */
+packed_board_t allocPackedBoard(int width, int height) {
+    packed_board_t board;
+    board.width = width;
+    board.height = height;
+    board.words = (width + 63) / 64;
+    board.data = calloc(sizeof(uint64_t), (size_t)(height + 2) * board.words);
+    assert(board.data != NULL);
+    board.mapping = NULL;
+    board.mappingLength = 0;
+
+    return board;
+}
+
+/*
+ * Free memory of a bit-packed board, or unmap it
+ */
+void freePackedBoard(packed_board_t board) {
+    if (board.mapping != NULL) {
+        munmap(board.mapping, board.mappingLength);
+    } else {
+        free(board.data);
+    }
+}
+
+/*
+ * Return the number of living cells of a bit-packed board
+ * The padding bits are always dead
+ */
+long long packedPopulation(packed_board_t board) {
+    const uint64_t* data = packedRow(board, 0);
+    long long population = 0;
+
+    #pragma omp parallel for reduction(+:population)
+    for (size_t k = 0; k < (size_t)board.height * board.words; k++) {
+        population += __builtin_popcountll(data[k]);
+    }
+    return population;
+}
+
+/*
+ * Return a pointer to the first word of the row i (-1 and height are the halo rows)
+ */
+uint64_t* packedRow(packed_board_t board, int i) {
+    return board.data + (size_t)(i + 1) * board.words;
+}
+
+/*
+ * Alocate the changes of a board of width x height cells, nothing changed
+ */
+changes_t allocChanges(int width, int height) {
+    changes_t changes;
+    changes.height = height;
+    changes.tileRows = (height + CHANGE_TILE - 1) / CHANGE_TILE;
+    changes.tileCols = (width + CHANGE_TILE - 1) / CHANGE_TILE;
+    changes.masks = (changes.tileCols + 63) / 64;
+    changes.rows = calloc(sizeof(uint64_t), (size_t)height * changes.masks);
+    changes.tiles = calloc(1, (size_t)changes.tileRows * changes.tileCols);
+    assert(changes.rows != NULL && changes.tiles != NULL);
+    return changes;
+}
+
+/*
+ * Free memory of the changes of a board
+ */
+void freeChanges(changes_t changes) {
+    free(changes.rows);
+    free(changes.tiles);
+}
+
+/*
+ * Forget the changed rows, before a kernel which only adds to them
+ */
+void clearChanges(changes_t* changes) {
+    memset(changes->rows, 0, (size_t)changes->height * changes->masks * sizeof(uint64_t));
+}
+
+/*
+ * Return the bits of the tiles of the cells j0 to j1 (excluded) of a row which
+ * differ between before and after, j0 starts a tile and the tiles share a word
+ */
+uint64_t changedCells(const char* before, const char* after, int j0, int j1) {
+    uint64_t bits = 0;
+    int j = j0;
+    // Whole tiles compared 8 cells at a time without a branch, the last one with memcmp
+    for (; j + CHANGE_TILE <= j1; j += CHANGE_TILE) {
+        uint64_t diff = 0;
+        for (int k = 0; k < CHANGE_TILE; k += 8) {
+            uint64_t b, a;
+            memcpy(&b, &before[j+k], 8);
+            memcpy(&a, &after[j+k], 8);
+            diff |= a ^ b;
+        }
+        bits |= (uint64_t)(diff != 0) << ((j / CHANGE_TILE) % 64);
+    }
+    if (j < j1 && memcmp(&before[j], &after[j], j1 - j)) {
+        bits |= (uint64_t)1 << ((j / CHANGE_TILE) % 64);
+    }
+    return bits;
+}
+
+/*
+ * Write the changed tiles of the row i of a board of one char per cell
+ */
+void markCharRow(changes_t* changes, int i, const char* before, const char* after, int width) {
+    uint64_t* row = changedRow(changes, i);
+    for (int w = 0; w < changes->masks; w++) {
+        int j0 = w * 64 * CHANGE_TILE;
+        row[w] = changedCells(before, after, j0, min(width, j0 + 64 * CHANGE_TILE));
+    }
+}
+
+/*
+ * Set the changed tiles from the changed rows
+ */
+void summarizeChanges(changes_t* changes) {
+    #pragma omp parallel for
+    for (int ti = 0; ti < changes->tileRows; ti++) {
+        char* tiles = &changes->tiles[(size_t)ti * changes->tileCols];
+        memset(tiles, 0, changes->tileCols);
+        for (int w = 0; w < changes->masks; w++) {
+            // The rows of the tile first, then a single pass over their bits
+            uint64_t bits = 0;
+            for (int i = ti * CHANGE_TILE; i < min((ti + 1) * CHANGE_TILE, changes->height); i++) {
+                bits |= changedRow(changes, i)[w];
             }
-            if (*size < MIN_SIZE) {
-                *size = MIN_SIZE;
+            for (; bits != 0; bits &= bits - 1) {
+                tiles[w * 64 + __builtin_ctzll(bits)] = 1;
             }
-        
-            board = allocBoard(*size);
-
-            // Fill the board with the file content
-            int i = 0;
-            int j = 0;
-            char c = 0;
-            while((c = fgetc(file)) != EOF) {
-                if (c == '\n') {
-                    i += 1;
-                    j = 0;
-                    if (i == *size) {
-                        break;
-                    }
-                } else if (j < *size) {
-                    if (c == '0') {
-                        board.data[idx(i, j, *size)] = 0;
-                    } else {
-                        board.data[idx(i, j, *size)] = 1;
-                    }
-
-                    j += 1;
-                }
+        }
+    }
+}
+
+/*
+ * Convert a board to its bit-packed representation
+ */
+void packBoard(board_t board, packed_board_t packed) {
+    assert(board.width == packed.width && board.height == packed.height);
+
+    #pragma omp parallel for
+    for (int i = 0; i < board.height; i++) {
+        uint64_t* row = packedRow(packed, i);
+        char* cells = &board.data[boardIdx(i, 0, board.width)];
+
+        for (int k = 0; k < packed.words; k++) {
+            uint64_t word = 0;
+            int end = min(64, board.width - k*64);
+            for (int b = 0; b < end; b++) {
+                word |= (uint64_t)(cells[k*64 + b] != 0) << b;
             }
+            row[k] = word;
+        }
+    }
+}
+
+/*
+ * Convert a bit-packed board back to one char per cell
+ */
+void unpackBoard(packed_board_t packed, board_t board) {
+    assert(board.width == packed.width && board.height == packed.height);
+
+    #pragma omp parallel for
+    for (int i = 0; i < board.height; i++) {
+        uint64_t* row = packedRow(packed, i);
+        char* cells = &board.data[boardIdx(i, 0, board.width)];
+
+        for (int j = 0; j < board.width; j++) {
+            cells[j] = (row[j / 64] >> (j % 64)) & 1;
         }
+    }
+}
+
+/*
+ * Generate the board with the given file (plain text, RLE, Life 1.06 or binary)
+ * Board dimensions can be given, 0 to doesn't set them
+ */
+board_t getBoard(char* filename, int* width, int* height) {
+    board_t board;
+
+    if (strcmp(filename, "") && isBinaryBoard(filename)) {
+        // Binary boards give their own dimensions
+        binary_header_t header;
+        packed_board_t packed = mapBinaryBoard(filename, &header);
+        *width = packed.width;
+        *height = packed.height;
+        board = allocBoard(*width, *height);
+        unpackBoard(packed, board);
+        freePackedBoard(packed);
+    } else if (strcmp(filename, "")) {
+        FILE* file = fopen(filename, "rb");
+        assert(file != NULL);
+
+        // The format is detected from the extension or the first bytes
+        board = readPattern(file, filename, width, height);
         fclose(file);
     } else {
-        if (*size == 0) {
-            *size = DEFAULT_SIZE;
+        if (*width == 0) {
+            *width = DEFAULT_SIZE;
         }
-        board = allocBoard(*size);
+        if (*height == 0) {
+            *height = *width;
+        }
+        board = allocBoard(*width, *height);
     }
 
     return board;
 }
 
 /**
- * Save a board to a file
+ * Save a board to a file, the format is given by the extension
  */
-void saveBoard(board_t board, int size) {
-    // Get formatted time for the filename
+void saveBoardAs(board_t board, const char* filename) {
+    int format = patternFormat(filename, NULL, 0);
+    if (format == FORMAT_BINARY) {
+        packed_board_t packed = allocPackedBoard(board.width, board.height);
+        packBoard(board, packed);
+        writeBinaryBoard(packed, 0, filename);
+        freePackedBoard(packed);
+        return;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    assert(file != NULL);
+
+    writePattern(board, file, format);
+    fclose(file);
+}
+
+/**
+ * Write the timestamped name of a save (saves_YYYYMMDDhhmmss.rle)
+ */
+void saveFileName(char* buffer, int length) {
     time_t now;
-    char buffer[29];
     struct tm* tm_info;
 
     time(&now);
     tm_info = localtime(&now);
-    strftime(buffer, 29, "saves_%Y%m%d%H%M%S.txt", tm_info);
+    strftime(buffer, length, "saves_%Y%m%d%H%M%S.rle", tm_info);
+}
 
-    FILE* file = fopen(buffer, "w");
-    assert(file != NULL);
+/**
+ * Save a board to a timestamped RLE file
+ */
+void saveBoard(board_t board) {
+    char buffer[29];
+    saveFileName(buffer, sizeof(buffer));
 
-    fprintf(file, "%d\n", size);
-    for(int i = 0; i < (size*size); i++) {
-        fprintf(file, "%d", board.data[i]);
-        if (i % size == (size-1)) {
-            fprintf(file, "\n");
-        }
-    }
+    saveBoardAs(board, buffer);
+}
 
-    fclose(file);
+/*
+ * Mixing function of splitmix64
+ */
+static inline uint64_t randomMix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
+/*
+ * Return 64 random cells, each one alive with the probability level / 2^RANDOM_PRECISION
+ * The draws only depend on the key and the counter, not on the previous draws
+ * The bits of level are read from the lowest, a 1 ors a new draw, a 0 ands it
+ */
+static inline uint64_t randomWord(uint64_t key, uint64_t counter, uint32_t level) {
+    if (level >= (1u << RANDOM_PRECISION)) {
+        return ~0ULL;
+    } else if (level == 0) {
+        return 0;
+    }
+
+    uint64_t draw = counter * RANDOM_PRECISION;
+    uint64_t word = 0;
+    for (int b = __builtin_ctz(level); b < RANDOM_PRECISION; b++, draw++) {
+        uint64_t bits = randomMix(key + (draw + 1) * 0x9e3779b97f4a7c15ULL);
+        word = ((level >> b) & 1 ? word | bits : word & bits);
+    }
+    return word;
+}
 
 /**
- * Randomly generate a part of a board
- * Range to generate : (initI -> initI+size; initJ -> initJ+size)
+ * Randomly generate a part of a board, each cell alive with the given density
+ * Range to generate : (initI -> initI+rows; initJ -> initJ+cols)
+ * A cell only depends on the seed, the density and its position, in a word of
+ * 64 cells of its row
  */
-void randomBoardPart(board_t board, int initI, int initJ, int partSize) {
-    for (int i = initI; i < initI+partSize; i++) {
-        for (int j = initJ; j < initJ+partSize; j++) {
-            board.data[idx(i, j, board.size)] = rand()%2;
+void randomBoardPart(board_t board, int initI, int initJ, int rows, int cols, double density, uint64_t seed) {
+    uint64_t key = randomMix(seed);
+    uint32_t level = (uint32_t)(max(0.0, min(1.0, density)) * (1u << RANDOM_PRECISION) + 0.5);
+    int words = (board.width + 63) / 64;
+
+    #pragma omp parallel for if ((long long)rows * cols >= RANDOM_PARALLEL_CELLS)
+    for (int i = initI; i < initI+rows; i++) {
+        char* row = &board.data[boardIdx(i, 0, board.width)];
+        for (int k = initJ / 64; k * 64 < initJ+cols; k++) {
+            uint64_t word = randomWord(key, (uint64_t)i * words + k, level);
+            int begin = max(initJ, k*64);
+            int end = min(initJ+cols, k*64 + 64);
+            for (int j = begin; j < end; j++) {
+                row[j] = (word >> (j - k*64)) & 1;
+            }
         }
     }
 }
@@ -165,31 +415,33 @@ void randomBoardPart(board_t board, int initI, int initJ, int partSize) {
  * Apply a vertical or horizontal symmetry on the middle of the board
  */
 void symmetryBoardPart(board_t board, int vertical) {
-    for (int i = 0; i < (vertical ? board.size/2 : board.size); i++) {
-        int nI =  (vertical ? board.size - i - 1 : i);
-        for (int j = 0; j < (vertical ? board.size : board.size/2); j++) {
-            int nJ =  (vertical ? j : board.size - j - 1);
+    for (int i = 0; i < (vertical ? board.height/2 : board.height); i++) {
+        int nI =  (vertical ? board.height - i - 1 : i);
+        for (int j = 0; j < (vertical ? board.width : board.width/2); j++) {
+            int nJ =  (vertical ? j : board.width - j - 1);
 
-            board.data[idx(nI, nJ, board.size)] = board.data[idx(i, j, board.size)];
+            board.data[boardIdx(nI, nJ, board.width)] = board.data[boardIdx(i, j, board.width)];
         }
     }
 }
 
 /**
- * Fill the board with random values
+ * Fill the board with random values, the same seed and density give the same
+ * board on every host, whatever the number of threads
  * rdmType : 1->full random, 2->vertical symm, 3->horizontal symm, 4->both symm
  */
-void randomBoard(board_t board, int rdmType) {
-    int size = board.size;
+void randomBoard(board_t board, int rdmType, double density, uint64_t seed) {
+    int rows = board.height/2 + board.height%2;
+    int cols = board.width/2 + board.width%2;
     if (rdmType == 1) {
-        randomBoardPart(board, 0, 0, size);
+        randomBoardPart(board, 0, 0, board.height, board.width, density, seed);
     } else {
-        randomBoardPart(board, 0, 0, size/2 + size%2);
+        randomBoardPart(board, 0, 0, rows, cols, density, seed);
         if (rdmType == 2) {
-            randomBoardPart(board, 0, size/2+size%2, size/2);
+            randomBoardPart(board, 0, cols, board.height/2, board.width/2, density, seed);
             symmetryBoardPart(board, 1);
         } else if (rdmType == 3) {
-            randomBoardPart(board, size/2+size%2, 0, size/2);
+            randomBoardPart(board, rows, 0, board.height/2, board.width/2, density, seed);
             symmetryBoardPart(board, 0);
         } else {
             symmetryBoardPart(board, 1);
@@ -31,40 +31,175 @@ SOFTWARE.
 #ifndef _FILE_H_
 #define _FILE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define DEFAULT_SIZE 20
+#define MIN_SIZE 3
+#define RANDOM_DENSITY 0.5
+/*
+ * Random cells are alive with a density rounded to 1/2^RANDOM_PRECISION, a
+ * word of 64 cells takes up to RANDOM_PRECISION draws (one at 0.5)
+ */
+#define RANDOM_PRECISION 16
+/*
+ * Smallest part of a board filled by several threads
+ */
+#define RANDOM_PARALLEL_CELLS (1 << 16)
 
+/*
+ * Board of one char per cell, surrounded by a ring of halo cells filled from
+ * the boundary (see boundary.h) so kernels never test the bounds
+ * data is the cell (0, 0), the rows are width+2 apart, see boardIdx
+ */
 typedef struct board {
     char* data;
-    int size;
+    int width;
+    int height;
 } board_t;
 
+/*
+ * Bit-packed board, one bit per cell
+ * Each row is padded to a whole number of 64-bit words, and a halo row above
+ * and below the board is filled from the boundary (see fillPackedHalo) so
+ * kernels never test the row bounds
+ * mapping is set when data lives in a memory mapped file (see binary.h)
+ */
+typedef struct packed_board {
+    uint64_t* data;
+    int width;
+    int height;
+    int words;
+    void* mapping;
+    size_t mappingLength;
+} packed_board_t;
+
+/*
+ * Cells changed by the last generation of the char and packed engines, by tiles
+ * of CHANGE_TILE x CHANGE_TILE cells (a word of a packed row). The bit t % 64 of
+ * the word t / 64 of the row i is set when a cell of the row i in the tile
+ * column t changed, each row is written by the thread which computes it
+ * summarizeChanges then gives the changed tiles in tiles, one char each
+ */
+#define CHANGE_TILE 64
+typedef struct changes {
+    uint64_t* rows;
+    char* tiles;
+    int height;
+    int masks;
+    int tileRows;
+    int tileCols;
+} changes_t;
+
 /*
  * Return the corresponding index in the flattened 2d-array
  */
 int idx(int i, int j, int size);
 /*
- * Alocate memory for a flat 2d-array of size (size x size)
+ * Return the index of the cell (i, j) in the data of a board of the given width
+ * -1, width and height are the halo cells
  */
-board_t allocBoard(int size);
+static inline long boardIdx(int i, int j, int width) {
+    return (long)i * (width + 2) + j;
+}
+/*
+ * Alocate memory for a board of width x height cells
+ */
+board_t allocBoard(int width, int height);
 /*
  * Free memory of a flat 2d-array
  */
 void freeBoard(board_t array);
 /*
- * Generate the board with the given file
- * Board size can be given, 0 to doesn't set it
+ * Copy the cells of a board into another board of the same dimensions
+ */
+void copyBoard(board_t src, board_t dst);
+/*
+ * Kill every cell of a board
+ */
+void clearBoard(board_t board);
+/*
+ * Return the number of living cells of a board
+ */
+long long boardPopulation(board_t board);
+/*
+ * Alocate memory for a bit-packed board of width x height cells
+ */
+packed_board_t allocPackedBoard(int width, int height);
+/*
+ * Free memory of a bit-packed board, or unmap it
+ */
+void freePackedBoard(packed_board_t board);
+/*
+ * Return the number of living cells of a bit-packed board
+ */
+long long packedPopulation(packed_board_t board);
+/*
+ * Return a pointer to the first word of the row i (-1 and height are the halo rows)
+ */
+uint64_t* packedRow(packed_board_t board, int i);
+/*
+ * Alocate the changes of a board of width x height cells, nothing changed
+ */
+changes_t allocChanges(int width, int height);
+/*
+ * Free memory of the changes of a board
+ */
+void freeChanges(changes_t changes);
+/*
+ * Forget the changed rows, before a kernel which only adds to them
+ */
+void clearChanges(changes_t* changes);
+/*
+ * Return the words of the changed tiles of the row i
+ */
+static inline uint64_t* changedRow(changes_t* changes, int i) {
+    return changes->rows + (size_t)i * changes->masks;
+}
+/*
+ * Return the bits of the tiles of the cells j0 to j1 (excluded) of a row which
+ * differ between before and after, j0 starts a tile and the tiles share a word
+ */
+uint64_t changedCells(const char* before, const char* after, int j0, int j1);
+/*
+ * Write the changed tiles of the row i of a board of one char per cell
+ */
+void markCharRow(changes_t* changes, int i, const char* before, const char* after, int width);
+/*
+ * Set the changed tiles from the changed rows
+ */
+void summarizeChanges(changes_t* changes);
+/*
+ * Convert a board to its bit-packed representation
+ */
+void packBoard(board_t board, packed_board_t packed);
+/*
+ * Convert a bit-packed board back to one char per cell
+ */
+void unpackBoard(packed_board_t packed, board_t board);
+/*
+ * Generate the board with the given file (plain text, RLE, Life 1.06 or binary)
+ * Board dimensions can be given, 0 to doesn't set them
+ */
+board_t getBoard(char* filename, int* width, int* height);
+/**
+ * Save a board to a file, the format is given by the extension
+ */
+void saveBoardAs(board_t board, const char* filename);
+/**
+ * Write the timestamped name of a save (saves_YYYYMMDDhhmmss.rle)
  */
-board_t getBoard(char* filename, int* size);
+void saveFileName(char* buffer, int length);
 /**
- * Save a board to a file
+ * Save a board to a timestamped RLE file
  */
-void saveBoard(board_t board, int size);
+void saveBoard(board_t board);
 
 /**
- * Randomly generate a part of a board
- * Range to generate : (initI -> initI+size; initJ -> initJ+size)
+ * Randomly generate a part of a board, each cell alive with the given density
+ * Range to generate : (initI -> initI+rows; initJ -> initJ+cols)
  */
-void randomBoardPart(board_t board, int initI, int initJ, int partSize);
+void randomBoardPart(board_t board, int initI, int initJ, int rows, int cols, double density, uint64_t seed);
 
 /**
  * Apply a vertical or horizontal symmetry on the middle of the board
@@ -72,9 +207,9 @@ void randomBoardPart(board_t board, int initI, int initJ, int partSize);
 void symmetryBoardPart(board_t board, int vertical);
 
 /**
- * Fill the board with random values
+ * Fill the board with random values, the same seed and density give the same board
  * rdmType : 1->full random, 2->vertical symm, 3->horizontal symm, 4->both symm
  */
-void randomBoard(board_t board, int rdmType);
+void randomBoard(board_t board, int rdmType, double density, uint64_t seed);
 
 #endif
\ No newline at end of file
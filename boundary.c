@@ -0,0 +1,266 @@
+/*
+ * Title    : Game of life / boundary
+ * Desc     : Boundary conditions, the halo cells around the boards
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "board.h"
+#include "boundary.h"
+
+static const char* boundaryNames[BOUNDARY_COUNT] = { "dead", "torus", "mirror", "klein" };
+static int currentBoundary = BOUNDARY_DEAD;
+
+/*
+ * Return the boundary of the given name, -1 if unknown
+ */
+int parseBoundary(const char* name) {
+    for (int b = 0; b < BOUNDARY_COUNT; b++) {
+        if (!strcmp(name, boundaryNames[b])) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Return the name of a boundary
+ */
+const char* boundaryName(int boundary) {
+    return boundaryNames[boundary];
+}
+
+/*
+ * Select the boundary used by the engines, dead by default
+ */
+void setBoundary(int boundary) {
+    currentBoundary = boundary;
+}
+
+/*
+ * Return the boundary used by the engines
+ */
+int getBoundary(void) {
+    return currentBoundary;
+}
+
+/*
+ * Fill the halo cells of a board for the boundary, once per generation
+ * The halo columns are filled first, then the halo rows are copied whole
+ * from the filled rows, which also gives the corners
+ */
+void fillHalo(board_t board) {
+    int width = board.width;
+    int height = board.height;
+    char* top = &board.data[boardIdx(-1, -1, width)];
+    char* bottom = &board.data[boardIdx(height, -1, width)];
+    const char* first = &board.data[boardIdx(0, -1, width)];
+    const char* last = &board.data[boardIdx(height-1, -1, width)];
+
+    for (int i = 0; i < height; i++) {
+        char* row = &board.data[boardIdx(i, 0, width)];
+        switch (currentBoundary) {
+            case BOUNDARY_TORUS:
+            case BOUNDARY_KLEIN:
+                row[-1] = row[width-1];
+                row[width] = row[0];
+                break;
+            case BOUNDARY_MIRROR:
+                row[-1] = row[0];
+                row[width] = row[width-1];
+                break;
+            default:
+                row[-1] = 0;
+                row[width] = 0;
+                break;
+        }
+    }
+
+    switch (currentBoundary) {
+        case BOUNDARY_TORUS:
+            memcpy(top, last, width + 2);
+            memcpy(bottom, first, width + 2);
+            break;
+        case BOUNDARY_MIRROR:
+            memcpy(top, first, width + 2);
+            memcpy(bottom, last, width + 2);
+            break;
+        case BOUNDARY_KLEIN:
+            for (int j = 0; j < width + 2; j++) {
+                top[j] = last[width + 1 - j];
+                bottom[j] = first[width + 1 - j];
+            }
+            break;
+        default:
+            memset(top, 0, width + 2);
+            memset(bottom, 0, width + 2);
+            break;
+    }
+}
+
+/*
+ * Fill the halo cells of a board of one word per cell, like fillHalo
+ * cells points to the cell (0, 0), the cells are indexed with boardIdx
+ */
+void fillLanesHalo(uint64_t* cells, int width, int height) {
+    size_t length = (width + 2) * sizeof(uint64_t);
+    uint64_t* top = &cells[boardIdx(-1, -1, width)];
+    uint64_t* bottom = &cells[boardIdx(height, -1, width)];
+    const uint64_t* first = &cells[boardIdx(0, -1, width)];
+    const uint64_t* last = &cells[boardIdx(height-1, -1, width)];
+
+    for (int i = 0; i < height; i++) {
+        uint64_t* row = &cells[boardIdx(i, 0, width)];
+        switch (currentBoundary) {
+            case BOUNDARY_TORUS:
+            case BOUNDARY_KLEIN:
+                row[-1] = row[width-1];
+                row[width] = row[0];
+                break;
+            case BOUNDARY_MIRROR:
+                row[-1] = row[0];
+                row[width] = row[width-1];
+                break;
+            default:
+                row[-1] = 0;
+                row[width] = 0;
+                break;
+        }
+    }
+
+    switch (currentBoundary) {
+        case BOUNDARY_TORUS:
+            memcpy(top, last, length);
+            memcpy(bottom, first, length);
+            break;
+        case BOUNDARY_MIRROR:
+            memcpy(top, first, length);
+            memcpy(bottom, last, length);
+            break;
+        case BOUNDARY_KLEIN:
+            for (int j = 0; j < width + 2; j++) {
+                top[j] = last[width + 1 - j];
+                bottom[j] = first[width + 1 - j];
+            }
+            break;
+        default:
+            memset(top, 0, length);
+            memset(bottom, 0, length);
+            break;
+    }
+}
+
+/*
+ * Write the width cells of a bit-packed row in reverse order, the padding stays dead
+ */
+static void reverseRow(const uint64_t* row, uint64_t* out, int width, int words) {
+    memset(out, 0, words * sizeof(uint64_t));
+    for (int j = 0; j < width; j++) {
+        int from = width - 1 - j;
+        out[j / 64] |= ((row[from / 64] >> (from % 64)) & 1) << (j % 64);
+    }
+}
+
+/*
+ * Fill the halo rows (-1 and height) of a bit-packed board for the boundary
+ * The ghost columns are read from each row with packedGhost
+ */
+void fillPackedHalo(packed_board_t board) {
+    int height = board.height;
+    size_t length = board.words * sizeof(uint64_t);
+    uint64_t* top = packedRow(board, -1);
+    uint64_t* bottom = packedRow(board, height);
+
+    switch (currentBoundary) {
+        case BOUNDARY_TORUS:
+            memcpy(top, packedRow(board, height-1), length);
+            memcpy(bottom, packedRow(board, 0), length);
+            break;
+        case BOUNDARY_MIRROR:
+            memcpy(top, packedRow(board, 0), length);
+            memcpy(bottom, packedRow(board, height-1), length);
+            break;
+        case BOUNDARY_KLEIN:
+            reverseRow(packedRow(board, height-1), top, board.width, board.words);
+            reverseRow(packedRow(board, 0), bottom, board.width, board.words);
+            break;
+        default:
+            memset(top, 0, length);
+            memset(bottom, 0, length);
+            break;
+    }
+}
+
+/*
+ * Reverse the width cells of a bit-packed row in place
+ */
+static void reverseRowInPlace(uint64_t* row, int width) {
+    for (int j = 0, k = width - 1; j < k; j++, k--) {
+        uint64_t a = (row[j / 64] >> (j % 64)) & 1;
+        uint64_t b = (row[k / 64] >> (k % 64)) & 1;
+        if (a != b) {
+            row[j / 64] ^= (uint64_t)1 << (j % 64);
+            row[k / 64] ^= (uint64_t)1 << (k % 64);
+        }
+    }
+}
+
+/*
+ * Fill a halo row at an edge of the board from the row next to it
+ * Wrapped boundaries have received the halo from the opposite strip already
+ */
+static void fillStripEdge(packed_board_t strip, uint64_t* halo, const uint64_t* edge) {
+    size_t length = strip.words * sizeof(uint64_t);
+    switch (currentBoundary) {
+        case BOUNDARY_TORUS:
+            break;
+        case BOUNDARY_MIRROR:
+            memcpy(halo, edge, length);
+            break;
+        case BOUNDARY_KLEIN:
+            reverseRowInPlace(halo, strip.width);
+            break;
+        default:
+            memset(halo, 0, length);
+            break;
+    }
+}
+
+/*
+ * Fill the halo rows at the edges of the board of a strip of rows (see distrib.h)
+ * top and bottom tell if the strip holds the first or the last row of the board,
+ * the other halo rows and the wrapped ones are received from the other strips
+ */
+void fillStripHalo(packed_board_t strip, int top, int bottom) {
+    if (top) {
+        fillStripEdge(strip, packedRow(strip, -1), packedRow(strip, 0));
+    }
+    if (bottom) {
+        fillStripEdge(strip, packedRow(strip, strip.height), packedRow(strip, strip.height - 1));
+    }
+}
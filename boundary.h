@@ -0,0 +1,123 @@
+/*
+ * Title    : Game of life / boundary
+ * Desc     : Headers for the boundary conditions (halo cells around the boards)
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _BOUNDARY_H_
+#define _BOUNDARY_H_
+
+#include <stdint.h>
+#include "board.h"
+
+/*
+ * What lies outside of the board, given by the halo cells around it
+ * dead : empty cells
+ * torus : the opposite edge, the board wraps around
+ * mirror : the edge cell itself, the board is reflected
+ * klein : the opposite edge, the top and bottom ones flipped left to right
+ */
+#define BOUNDARY_DEAD 0
+#define BOUNDARY_TORUS 1
+#define BOUNDARY_MIRROR 2
+#define BOUNDARY_KLEIN 3
+#define BOUNDARY_COUNT 4
+
+/*
+ * Ghost cells of a bit-packed row : west has the cell left of column 0 in its
+ * bit 63 (like the word before the row), the cell right of the last column is
+ * in pad at the padding bit after the last cell, or in bit 0 of next (like the
+ * word after the row) when the row has no padding
+ */
+typedef struct ghost {
+    uint64_t west;
+    uint64_t pad;
+    uint64_t next;
+} ghost_t;
+
+/*
+ * Return the boundary of the given name, -1 if unknown
+ */
+int parseBoundary(const char* name);
+/*
+ * Return the name of a boundary
+ */
+const char* boundaryName(int boundary);
+/*
+ * Select the boundary used by the engines, dead by default
+ */
+void setBoundary(int boundary);
+/*
+ * Return the boundary used by the engines
+ */
+int getBoundary(void);
+/*
+ * Fill the halo cells of a board for the boundary, once per generation
+ */
+void fillHalo(board_t board);
+/*
+ * Fill the halo cells of a board of one word per cell, like fillHalo
+ * cells points to the cell (0, 0), the cells are indexed with boardIdx
+ */
+void fillLanesHalo(uint64_t* cells, int width, int height);
+/*
+ * Fill the halo rows (-1 and height) of a bit-packed board for the boundary
+ * The ghost columns are read from each row with packedGhost
+ */
+void fillPackedHalo(packed_board_t board);
+/*
+ * Fill the halo rows at the edges of the board of a strip of rows (see distrib.h)
+ * top and bottom tell if the strip holds the first or the last row of the board,
+ * the other halo rows and the wrapped ones are received from the other strips
+ */
+void fillStripHalo(packed_board_t strip, int top, int bottom);
+
+/*
+ * Return the ghost cells of a bit-packed row (or halo row) of width cells for the boundary
+ */
+static inline ghost_t packedGhost(const uint64_t* row, int width, int boundary) {
+    ghost_t ghost = { 0, 0, 0 };
+    if (boundary == BOUNDARY_DEAD) {
+        return ghost;
+    }
+
+    // Wrapped boards see the opposite column, a mirror the edge column itself
+    int westCol = (boundary == BOUNDARY_MIRROR ? 0 : width-1);
+    int eastCol = (boundary == BOUNDARY_MIRROR ? width-1 : 0);
+    uint64_t west = (row[westCol / 64] >> (westCol % 64)) & 1;
+    uint64_t east = (row[eastCol / 64] >> (eastCol % 64)) & 1;
+
+    ghost.west = west << 63;
+    if (width % 64 != 0) {
+        ghost.pad = east << (width % 64);
+    } else {
+        ghost.next = east;
+    }
+    return ghost;
+}
+
+#endif
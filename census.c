@@ -0,0 +1,895 @@
+/*
+ * Title    : Game of life / census
+ * Desc     : Census of random soups : thread pool, object splitting and canonical forms
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "omp.h"
+#include "board.h"
+#include "census.h"
+#include "ensemble.h"
+#include "sparse.h"
+#include "bench.h"
+#include "rule.h"
+#include "math.h"
+
+#define ARENA_BLOCK (1 << 20)
+#define TALLY_CAPACITY 1024
+/*
+ * Living cells at most CENSUS_DISTANCE rows and columns apart belong to the
+ * same object, so the phases of the toad or the pulsar stay in one piece
+ */
+#define CENSUS_DISTANCE 2
+/*
+ * Every CENSUS_CHECK generations, the objects at most CENSUS_BAND cells from
+ * the border are run alone, the spaceships among them (period at most
+ * CENSUS_SHIP_PERIOD, like the glider and the light, middle and heavy weight
+ * spaceships) are counted and removed before the dead border breaks them.
+ * A c/2 ship moves 2 cells between two searches
+ */
+#define CENSUS_CHECK 4
+#define CENSUS_BAND 6
+#define CENSUS_SHIP_PERIOD 4
+#define CENSUS_SHIP_SIZE 8
+/*
+ * A soup run on the plane which spreads over more cells isn't waited for
+ */
+#define CENSUS_MAX_SPREAD 1024
+
+/*
+ * Block of an arena, the memory follows the header
+ */
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t size;
+    size_t used;
+    char data[];
+} arena_block_t;
+
+/*
+ * Memory of a worker, allocated by bumping a pointer and freed all at once,
+ * the blocks are kept for the next soups
+ */
+typedef struct arena {
+    arena_block_t* first;
+    arena_block_t* current;
+} arena_t;
+
+/*
+ * Objects counted by a worker, open addressing on the hash of the key
+ */
+typedef struct tally {
+    census_object_t* slots;
+    size_t capacity;
+    size_t count;
+} tally_t;
+
+/*
+ * Soups shared by the workers, taken by batches of ENSEMBLE_LANES
+ */
+typedef struct census_job {
+    int width;
+    int height;
+    long long soups;
+    long long maxGens;
+    double density;
+    uint64_t seed;
+    atomic_llong nextBatch;
+} census_job_t;
+
+typedef struct census_worker {
+    pthread_t thread;
+    census_job_t* job;
+    arena_t scratch;
+    arena_t keys;
+    tally_t tally;
+    sparse_t* universe;
+    sparse_t* saved;
+    long long unsettled;
+    long long plane;
+    long long total;
+} census_worker_t;
+
+/*
+ * Known objects, named in the report
+ */
+static const char* knownNames[] = { "block", "blinker", "beehive", "loaf", "boat", "ship", "tub", "pond",
+                                    "glider", "toad", "beacon", "long boat", "barge", "mango", "pulsar" };
+static const char* knownRows[] = { "11/11", "111", ".11./1..1/.11.", ".11./1..1/.1.1/..1.", "11./1.1/.1.",
+                                   "11./1.1/.11", ".1./1.1/.1.", ".11./1..1/1..1/.11.", ".1./..1/111",
+                                   ".111/111.", "11../11../..11/..11", "11../1.1./.1.1/..1.",
+                                   ".1../1.1./.1.1/..1.", ".11../1..1./.1..1/..11.",
+                                   "..111...111../............./1....1.1....1/1....1.1....1/1....1.1....1/"
+                                   "..111...111../............./..111...111../1....1.1....1/1....1.1....1/"
+                                   "1....1.1....1/............./..111...111.." };
+#define KNOWN_COUNT ((int)(sizeof(knownNames) / sizeof(knownNames[0])))
+#define KNOWN_MAX_PERIOD 16
+
+/*
+ * Return size bytes of an arena, aligned on 16 bytes
+ */
+static void* arenaAlloc(arena_t* arena, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    arena_block_t* block = arena->current;
+    while (block != NULL && block->used + size > block->size) {
+        block = block->next;
+        if (block != NULL) {
+            block->used = 0;
+        }
+    }
+    if (block == NULL) {
+        size_t capacity = max(size, (size_t)ARENA_BLOCK);
+        block = malloc(sizeof(arena_block_t) + capacity);
+        assert(block != NULL);
+        block->next = NULL;
+        block->size = capacity;
+        block->used = 0;
+        if (arena->current != NULL) {
+            // Inserted after the current block, the blocks after it are kept
+            block->next = arena->current->next;
+            arena->current->next = block;
+        } else {
+            arena->first = block;
+        }
+    }
+    arena->current = block;
+
+    void* data = block->data + block->used;
+    block->used += size;
+    return data;
+}
+
+/*
+ * Free everything allocated in an arena, its blocks are used again
+ */
+static void arenaReset(arena_t* arena) {
+    arena->current = arena->first;
+    if (arena->first != NULL) {
+        arena->first->used = 0;
+    }
+}
+
+/*
+ * Free the blocks of an arena
+ */
+static void arenaFree(arena_t* arena) {
+    arena_block_t* block = arena->first;
+    while (block != NULL) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = arena->current = NULL;
+}
+
+/*
+ * FNV-1a of a key
+ */
+static uint64_t keyHash(const char* key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char* c = key; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Alocate an empty tally
+ */
+static tally_t allocTally(size_t capacity) {
+    tally_t tally;
+    tally.capacity = capacity;
+    tally.count = 0;
+    tally.slots = calloc(capacity, sizeof(census_object_t));
+    assert(tally.slots != NULL);
+    return tally;
+}
+
+/*
+ * Return the slot of a key, empty (key NULL) if it isn't counted yet
+ */
+static census_object_t* tallySlot(tally_t* tally, uint64_t hash, const char* key) {
+    size_t k = hash & (tally->capacity - 1);
+    while (tally->slots[k].key != NULL && (tally->slots[k].hash != hash || strcmp(tally->slots[k].key, key))) {
+        k = (k + 1) & (tally->capacity - 1);
+    }
+    return &tally->slots[k];
+}
+
+/*
+ * Count an object, the key is copied to the arena the first time
+ */
+static void tallyAdd(tally_t* tally, arena_t* keys, const census_object_t* object) {
+    if (2 * (tally->count + 1) > tally->capacity) {
+        tally_t larger = allocTally(2 * tally->capacity);
+        for (size_t k = 0; k < tally->capacity; k++) {
+            if (tally->slots[k].key != NULL) {
+                *tallySlot(&larger, tally->slots[k].hash, tally->slots[k].key) = tally->slots[k];
+                larger.count += 1;
+            }
+        }
+        free(tally->slots);
+        *tally = larger;
+    }
+
+    census_object_t* slot = tallySlot(tally, object->hash, object->key);
+    if (slot->key == NULL) {
+        *slot = *object;
+        slot->key = arenaAlloc(keys, strlen(object->key) + 1);
+        strcpy(slot->key, object->key);
+        slot->count = 0;
+        tally->count += 1;
+    }
+    slot->count += object->count;
+}
+
+/*
+ * Next generation of a small board of dead boundary, its halo stays dead
+ */
+static void stepObject(board_t curr, board_t next, rule_t rule) {
+    for (int i = 0; i < curr.height; i++) {
+        for (int j = 0; j < curr.width; j++) {
+            int sum = 0;
+            for (int di = -1; di <= 1; di++) {
+                for (int dj = -1; dj <= 1; dj++) {
+                    sum += curr.data[boardIdx(i + di, j + dj, curr.width)];
+                }
+            }
+            int cell = curr.data[boardIdx(i, j, curr.width)];
+            next.data[boardIdx(i, j, next.width)] = ruleNext(cell, sum - cell, rule.birth, rule.survival);
+        }
+    }
+}
+
+/*
+ * Return a board of the arena, its halo included
+ */
+static board_t arenaBoard(arena_t* arena, int width, int height) {
+    board_t board;
+    board.width = width;
+    board.height = height;
+    size_t length = (size_t)(width + 2) * (height + 2);
+    char* halo = arenaAlloc(arena, length);
+    memset(halo, 0, length);
+    board.data = halo - boardIdx(-1, -1, width);
+    return board;
+}
+
+/*
+ * Write the code of the living cells of a board seen through a symmetry
+ * (bit 0 : flip the rows, bit 1 : flip the columns, bit 2 : transpose) to
+ * buffer, their number to cells and the corner of their bounding box to
+ * origin (row and column). Return the length of the code, 0 if the board is
+ * empty
+ */
+static int symmetryCode(board_t board, int symmetry, char* buffer, int* cells, int* origin, arena_t* arena) {
+    int i0 = board.height, i1 = -1, j0 = board.width, j1 = -1;
+    *cells = 0;
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            if (board.data[boardIdx(i, j, board.width)]) {
+                *cells += 1;
+                i0 = min(i0, i);
+                i1 = max(i1, i);
+                j0 = min(j0, j);
+                j1 = max(j1, j);
+            }
+        }
+    }
+    origin[0] = i0;
+    origin[1] = j0;
+    if (i1 < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+
+    int rows = i1 - i0 + 1, cols = j1 - j0 + 1;
+    int height = ((symmetry & 4) ? cols : rows);
+    int width = ((symmetry & 4) ? rows : cols);
+    int digits = (width + 3) / 4;
+    int length = sprintf(buffer, "%dx%d:", width, height);
+    char* nibbles = arenaAlloc(arena, digits);
+
+    for (int y = 0; y < height; y++) {
+        memset(nibbles, 0, digits);
+        for (int x = 0; x < width; x++) {
+            int i = ((symmetry & 4) ? x : y), j = ((symmetry & 4) ? y : x);
+            i = ((symmetry & 1) ? i1 - i : i0 + i);
+            j = ((symmetry & 2) ? j1 - j : j0 + j);
+            if (board.data[boardIdx(i, j, board.width)]) {
+                nibbles[x / 4] |= 1 << (x % 4);
+            }
+        }
+        for (int d = 0; d < digits; d++) {
+            buffer[length++] = "0123456789abcdef"[(int)nibbles[d]];
+        }
+        buffer[length++] = (y + 1 < height ? '.' : '\0');
+    }
+    return length - 1;
+}
+
+/*
+ * Classify the object of the given cells : run it alone for at most maxPhases
+ * generations, until it comes back to its first phase (its period), and keep
+ * the smallest code of its phases in every orientation
+ * The object is written to object, its key to the arena
+ */
+static void classifyObject(const int* cells, int count, int maxPhases, arena_t* arena, census_object_t* object) {
+    int i0 = cells[0], i1 = cells[0], j0 = cells[1], j1 = cells[1];
+    for (int c = 1; c < count; c++) {
+        i0 = min(i0, cells[2*c]);
+        i1 = max(i1, cells[2*c]);
+        j0 = min(j0, cells[2*c+1]);
+        j1 = max(j1, cells[2*c+1]);
+    }
+
+    // Spaceships move at most a cell per generation
+    int margin = maxPhases + 2;
+    int width = j1 - j0 + 1 + 2*margin, height = i1 - i0 + 1 + 2*margin;
+    board_t curr = arenaBoard(arena, width, height);
+    board_t next = arenaBoard(arena, width, height);
+    for (int c = 0; c < count; c++) {
+        curr.data[boardIdx(cells[2*c] - i0 + margin, cells[2*c+1] - j0 + margin, width)] = 1;
+    }
+
+    // Room for the code of any orientation of the board
+    size_t side = max(width, height);
+    size_t size = (side / 4 + 2) * side + 32;
+    char* first = arenaAlloc(arena, size);
+    char* best = arenaAlloc(arena, size);
+    char* code = arenaAlloc(arena, size);
+    rule_t rule = getRule();
+
+    // The cells are the ones of the phase of the smallest code
+    int population, origin[2];
+    symmetryCode(curr, 0, first, &population, origin, arena);
+    strcpy(best, first);
+    object->period = 0;
+    object->cells = population;
+    for (int phase = 0; phase < maxPhases; phase++) {
+        for (int s = 1; s < 8; s++) {
+            symmetryCode(curr, s, code, &population, origin, arena);
+            if (strcmp(code, best) < 0) {
+                strcpy(best, code);
+                object->cells = population;
+            }
+        }
+
+        stepObject(curr, next, rule);
+        board_t tmp = curr;
+        curr = next;
+        next = tmp;
+
+        if (symmetryCode(curr, 0, code, &population, origin, arena) == 0) {
+            break;
+        }
+        if (!strcmp(code, first)) {
+            object->period = phase + 1;
+            break;
+        }
+        if (strcmp(code, best) < 0) {
+            strcpy(best, code);
+            object->cells = population;
+        }
+    }
+
+    object->key = best;
+    object->hash = keyHash(best);
+    object->name = NULL;
+    object->count = 1;
+}
+
+/*
+ * Return 1 if the object of the given cells is a spaceship of period at most
+ * CENSUS_SHIP_PERIOD and CENSUS_SHIP_SIZE cells wide : run alone, it comes back
+ * to its first phase somewhere else. The spaceships move at most a cell every
+ * two generations
+ */
+static int movingObject(const int* cells, int count, arena_t* arena) {
+    int i0 = cells[0], i1 = cells[0], j0 = cells[1], j1 = cells[1];
+    for (int c = 1; c < count; c++) {
+        i0 = min(i0, cells[2*c]);
+        i1 = max(i1, cells[2*c]);
+        j0 = min(j0, cells[2*c+1]);
+        j1 = max(j1, cells[2*c+1]);
+    }
+    if (i1 - i0 >= CENSUS_SHIP_SIZE || j1 - j0 >= CENSUS_SHIP_SIZE) {
+        return 0;
+    }
+
+    int margin = CENSUS_SHIP_PERIOD / 2 + 2;
+    int width = j1 - j0 + 1 + 2*margin, height = i1 - i0 + 1 + 2*margin;
+    board_t curr = arenaBoard(arena, width, height);
+    board_t next = arenaBoard(arena, width, height);
+    for (int c = 0; c < count; c++) {
+        curr.data[boardIdx(cells[2*c] - i0 + margin, cells[2*c+1] - j0 + margin, width)] = 1;
+    }
+
+    size_t size = (width / 4 + 2) * height + 32;
+    char* first = arenaAlloc(arena, size);
+    char* code = arenaAlloc(arena, size);
+    rule_t rule = getRule();
+    int population, start[2], origin[2];
+    symmetryCode(curr, 0, first, &population, start, arena);
+
+    for (int phase = 0; phase < CENSUS_SHIP_PERIOD; phase++) {
+        stepObject(curr, next, rule);
+        board_t tmp = curr;
+        curr = next;
+        next = tmp;
+
+        if (symmetryCode(curr, 0, code, &population, origin, arena) == 0) {
+            return 0;
+        }
+        if (!strcmp(code, first)) {
+            return (origin[0] != start[0] || origin[1] != start[1]);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Write to cells the living cells of the object of the cell (i, j), return
+ * their number. Its cells are cleared on the way
+ */
+static int fillObject(board_t board, int i, int j, int* cells) {
+    // Flood fill, the list of cells is its own queue
+    int count = 1, head = 0;
+    cells[0] = i;
+    cells[1] = j;
+    board.data[boardIdx(i, j, board.width)] = 0;
+    while (head < count) {
+        int ci = cells[2*head], cj = cells[2*head+1];
+        head += 1;
+        for (int ni = max(ci - CENSUS_DISTANCE, 0); ni <= min(ci + CENSUS_DISTANCE, board.height - 1); ni++) {
+            for (int nj = max(cj - CENSUS_DISTANCE, 0); nj <= min(cj + CENSUS_DISTANCE, board.width - 1); nj++) {
+                if (board.data[boardIdx(ni, nj, board.width)]) {
+                    board.data[boardIdx(ni, nj, board.width)] = 0;
+                    cells[2*count] = ni;
+                    cells[2*count+1] = nj;
+                    count += 1;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+/*
+ * Split a board in objects and count them, the cells are cleared on the way
+ */
+static long long countObjects(board_t board, int period, arena_t* scratch, arena_t* keys, tally_t* tally) {
+    int* cells = arenaAlloc(scratch, (size_t)board.width * board.height * 2 * sizeof(int));
+    long long objects = 0;
+    int maxPhases = min(period, CENSUS_MAX_PERIOD);
+
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            if (board.data[boardIdx(i, j, board.width)]) {
+                census_object_t object;
+                int count = fillObject(board, i, j, cells);
+                classifyObject(cells, count, maxPhases, scratch, &object);
+                tallyAdd(tally, keys, &object);
+                objects += 1;
+            }
+        }
+    }
+    return objects;
+}
+
+/*
+ * Count the spaceships close to the border of a board and write their cells
+ * to removed (row and column, length counts them), board is cleared on the way
+ * With changes, only the objects with a cell changed in the lane b of changes
+ * (see ensembleBorderChanges) are run, a still object can't be a spaceship,
+ * else the ones with a cell at most CENSUS_BAND cells from the border
+ */
+static long long removeShips(board_t board, const uint64_t* changes, int b, int* removed, int* length,
+                             arena_t* scratch, arena_t* keys, tally_t* tally) {
+    int* cells = arenaAlloc(scratch, (size_t)board.width * board.height * 2 * sizeof(int));
+    const uint64_t* changed = (changes != NULL ? changes - boardIdx(-1, -1, board.width) : NULL);
+    int band = CENSUS_BAND;
+    long long ships = 0;
+
+    for (int i = 0; i < board.height; i++) {
+        int full = (i < band || i >= board.height - band || 2*band >= board.width);
+        for (int j = 0; j < board.width; j += (full || j != band - 1 ? 1 : board.width - 2*band + 1)) {
+            long k = boardIdx(i, j, board.width);
+            if (board.data[k] && (changed == NULL || ((changed[k] >> b) & 1))) {
+                int count = fillObject(board, i, j, cells);
+                if (movingObject(cells, count, scratch)) {
+                    census_object_t object;
+                    classifyObject(cells, count, CENSUS_SHIP_PERIOD, scratch, &object);
+                    tallyAdd(tally, keys, &object);
+                    memcpy(&removed[2 * *length], cells, (size_t)count * 2 * sizeof(int));
+                    *length += count;
+                    ships += 1;
+                }
+            }
+        }
+    }
+    return ships;
+}
+
+/*
+ * Run a soup grown to the border of its board on the unbounded plane, from
+ * generation until it is periodic (at most maxGens generations) or spreads
+ * over CENSUS_MAX_SPREAD cells, and count its objects. Its spaceships are
+ * counted and removed when its bounding box changes
+ */
+static void planeLoop(census_worker_t* worker, board_t board, long long generation, long long maxGens, int* removed) {
+    sparseLoad(worker->universe, board);
+    sparseCopy(worker->saved, worker->universe);
+    long long savedGen = generation, power = 1, period = -1;
+    int64_t bounds[4] = { 0, 0, -1, -1 };
+
+    // Brent's cycle detection, the board is saved again after a removal
+    while (period < 0 && generation < maxGens) {
+        calculateStateSparse(worker->universe);
+        generation += 1;
+        if (sparseEqual(worker->universe, worker->saved)) {
+            period = generation - savedGen;
+            break;
+        }
+        if (generation - savedGen == power) {
+            sparseCopy(worker->saved, worker->universe);
+            savedGen = generation;
+            power *= 2;
+        }
+        if (generation % CENSUS_CHECK != 0) {
+            continue;
+        }
+
+        int64_t i0, j0, i1, j1;
+        if (!sparseBounds(worker->universe, &i0, &j0, &i1, &j1)) {
+            period = 1;
+        } else if (i1 - i0 >= CENSUS_MAX_SPREAD || j1 - j0 >= CENSUS_MAX_SPREAD) {
+            break;
+        } else if (i0 != bounds[0] || j0 != bounds[1] || i1 != bounds[2] || j1 != bounds[3]) {
+            arenaReset(&worker->scratch);
+            board_t window = arenaBoard(&worker->scratch, (int)(j1 - j0 + 1), (int)(i1 - i0 + 1));
+            sparseStoreAt(worker->universe, window, i0, j0);
+            int length = 0;
+            worker->total += removeShips(window, NULL, 0, removed, &length, &worker->scratch, &worker->keys, &worker->tally);
+            for (int c = 0; c < length; c++) {
+                sparseKill(worker->universe, i0 + removed[2*c], j0 + removed[2*c+1]);
+            }
+            if (length > 0) {
+                sparseCopy(worker->saved, worker->universe);
+                savedGen = generation;
+                power = 1;
+            }
+            bounds[0] = i0;
+            bounds[1] = j0;
+            bounds[2] = i1;
+            bounds[3] = j1;
+        }
+    }
+
+    int64_t i0, j0, i1, j1;
+    if (period < 0) {
+        worker->unsettled += 1;
+    } else if (sparseBounds(worker->universe, &i0, &j0, &i1, &j1)) {
+        arenaReset(&worker->scratch);
+        board_t window = arenaBoard(&worker->scratch, (int)(j1 - j0 + 1), (int)(i1 - i0 + 1));
+        sparseStoreAt(worker->universe, window, i0, j0);
+        worker->total += countObjects(window, (int)min(period, (long long)CENSUS_MAX_PERIOD), &worker->scratch, &worker->keys, &worker->tally);
+    }
+}
+
+/*
+ * Worker of the thread pool : takes batches of soups, runs them as an ensemble
+ * until they are periodic, and counts their objects in its own tally
+ */
+static void* censusLoop(void* arg) {
+    census_worker_t* worker = arg;
+    census_job_t* job = worker->job;
+    int width = job->width + 2*CENSUS_MARGIN;
+    int height = job->height + 2*CENSUS_MARGIN;
+    long long batches = (job->soups + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES;
+
+    ensemble_t ensemble = allocEnsemble(width, height, ENSEMBLE_LANES);
+    board_t board = allocBoard(width, height);
+    board_t soup = allocBoard(job->width, job->height);
+    uint64_t* border = calloc(ensemble.cells, sizeof(uint64_t));
+    uint64_t* changes = calloc(ensemble.cells, sizeof(uint64_t));
+    int* removed = malloc((size_t)width * height * 2 * sizeof(int));
+    assert(border != NULL && changes != NULL && removed != NULL);
+    worker->universe = sparseCreate(soup);
+    worker->saved = sparseCreate(soup);
+
+    long long batch;
+    while ((batch = atomic_fetch_add(&job->nextBatch, 1)) < batches) {
+        long long first = batch * ENSEMBLE_LANES;
+        int count = (int)min((long long)ENSEMBLE_LANES, job->soups - first);
+
+        // Each soup has its own seed, whatever the worker which runs it
+        clearEnsemble(&ensemble);
+        clearBoard(board);
+        memset(border, 0, ensemble.cells * sizeof(uint64_t));
+        for (int b = 0; b < count; b++) {
+            randomBoard(soup, 1, job->density, job->seed + first + b);
+            for (int i = 0; i < soup.height; i++) {
+                memcpy(&board.data[boardIdx(i + CENSUS_MARGIN, CENSUS_MARGIN, width)],
+                       &soup.data[boardIdx(i, 0, soup.width)], soup.width);
+            }
+            setEnsembleBoard(&ensemble, b, board);
+        }
+
+        // The soups run on the plane are cleared from the ensemble, they are periodic there
+        uint64_t plane = 0;
+        while (!ensembleSettled(&ensemble) && ensemble.generation < job->maxGens) {
+            stepEnsemble(&ensemble, min((long long)CENSUS_CHECK, job->maxGens - ensemble.generation));
+
+            // The lanes already periodic have no spaceship, the still objects
+            // of the border are only searched once
+            uint64_t lanes = ensembleBorderChanges(&ensemble, 0, CENSUS_BAND, border, changes) & ~ensemble.periodic[0];
+            while (lanes != 0) {
+                int b = __builtin_ctzll(lanes);
+                lanes &= lanes - 1;
+                arenaReset(&worker->scratch);
+                getEnsembleBoard(&ensemble, b, board);
+                int length = 0;
+                worker->total += removeShips(board, changes, b, removed, &length, &worker->scratch, &worker->keys, &worker->tally);
+                if (length > 0) {
+                    killEnsembleCells(&ensemble, b, removed, length);
+                }
+            }
+
+            // The dead border would change the soups which grow to it before
+            // the next search
+            lanes = ensembleBorderLanes(&ensemble, 0, CENSUS_CHECK + 1) & ~ensemble.periodic[0] & ~plane;
+            while (lanes != 0) {
+                int b = __builtin_ctzll(lanes);
+                lanes &= lanes - 1;
+                getEnsembleBoard(&ensemble, b, board);
+                planeLoop(worker, board, ensemble.generation, job->maxGens, removed);
+                worker->plane += 1;
+                plane |= (uint64_t)1 << b;
+
+                int length = 0;
+                getEnsembleBoard(&ensemble, b, board);
+                for (int i = 0; i < height; i++) {
+                    for (int j = 0; j < width; j++) {
+                        if (board.data[boardIdx(i, j, width)]) {
+                            removed[2*length] = i;
+                            removed[2*length+1] = j;
+                            length += 1;
+                        }
+                    }
+                }
+                killEnsembleCells(&ensemble, b, removed, length);
+            }
+        }
+
+        for (int b = 0; b < count; b++) {
+            if ((plane >> b) & 1) {
+                continue;
+            } else if (ensemble.period[b] < 0) {
+                worker->unsettled += 1;
+                continue;
+            }
+            arenaReset(&worker->scratch);
+            getEnsembleBoard(&ensemble, b, board);
+            worker->total += countObjects(board, ensemble.period[b], &worker->scratch, &worker->keys, &worker->tally);
+        }
+    }
+
+    sparseFree(worker->universe);
+    sparseFree(worker->saved);
+    free(removed);
+    free(border);
+    free(changes);
+    freeBoard(soup);
+    freeBoard(board);
+    freeEnsemble(ensemble);
+    return NULL;
+}
+
+/*
+ * Order of the report : decreasing count, then key
+ */
+static int compareObjects(const void* a, const void* b) {
+    const census_object_t* x = a;
+    const census_object_t* y = b;
+    if (x->count != y->count) {
+        return (x->count < y->count) - (x->count > y->count);
+    }
+    return strcmp(x->key, y->key);
+}
+
+/*
+ * Write the keys of the known objects to keys, from their rows given as text
+ */
+static void knownKeys(char** keys) {
+    arena_t arena = { NULL, NULL };
+    for (int k = 0; k < KNOWN_COUNT; k++) {
+        const char* rows = knownRows[k];
+        int* cells = arenaAlloc(&arena, strlen(rows) * 2 * sizeof(int));
+        int count = 0;
+        for (int i = 0, j = 0; *rows != '\0'; rows++) {
+            if (*rows == '/') {
+                i += 1;
+                j = 0;
+                continue;
+            }
+            if (*rows == '1') {
+                cells[2*count] = i;
+                cells[2*count+1] = j;
+                count += 1;
+            }
+            j += 1;
+        }
+
+        // Their periods are small, a short run finds them
+        census_object_t known;
+        classifyObject(cells, count, KNOWN_MAX_PERIOD, &arena, &known);
+        keys[k] = strdup(known.key);
+        assert(keys[k] != NULL);
+    }
+    arenaFree(&arena);
+}
+
+/*
+ * Run soups of width x height random cells at density, the soup k from seed + k,
+ * each one in the middle of CENSUS_MARGIN dead cells, until they are periodic
+ * (at most maxGens generations), then count the objects left
+ * The spaceships are counted and removed before they reach the border, the
+ * soups which still grow to it go on on the unbounded plane
+ * The soups are spread over threads (0 : as many as OpenMP uses), the results
+ * don't depend on their number
+ */
+census_t runCensus(int width, int height, long long soups, long long maxGens, double density, uint64_t seed, int threads) {
+    census_job_t job;
+    job.width = width;
+    job.height = height;
+    job.soups = soups;
+    job.maxGens = maxGens;
+    job.density = density;
+    job.seed = seed;
+    atomic_init(&job.nextBatch, 0);
+
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    census_worker_t* workers = calloc(threads, sizeof(census_worker_t));
+    assert(workers != NULL);
+    double begin = benchClock();
+    for (int t = 0; t < threads; t++) {
+        workers[t].job = &job;
+        workers[t].tally = allocTally(TALLY_CAPACITY);
+        int err = pthread_create(&workers[t].thread, NULL, censusLoop, &workers[t]);
+        assert(err == 0);
+    }
+
+    // The tallies of the workers are merged once they are done
+    census_t census;
+    tally_t merged = allocTally(TALLY_CAPACITY);
+    arena_t keys = { NULL, NULL };
+    census.soups = soups;
+    census.unsettled = 0;
+    census.plane = 0;
+    census.total = 0;
+    census.threads = threads;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        census.unsettled += workers[t].unsettled;
+        census.plane += workers[t].plane;
+        census.total += workers[t].total;
+        for (size_t k = 0; k < workers[t].tally.capacity; k++) {
+            if (workers[t].tally.slots[k].key != NULL) {
+                tallyAdd(&merged, &keys, &workers[t].tally.slots[k]);
+            }
+        }
+        free(workers[t].tally.slots);
+        arenaFree(&workers[t].keys);
+        arenaFree(&workers[t].scratch);
+    }
+    free(workers);
+    census.duration = benchClock() - begin;
+
+    // Copied out of the table, the keys are kept by their own allocation
+    char* known[KNOWN_COUNT];
+    knownKeys(known);
+    census.count = (int)merged.count;
+    census.objects = malloc((merged.count + 1) * sizeof(census_object_t));
+    assert(census.objects != NULL);
+    int n = 0;
+    for (size_t k = 0; k < merged.capacity; k++) {
+        if (merged.slots[k].key != NULL) {
+            census.objects[n] = merged.slots[k];
+            census.objects[n].key = strdup(merged.slots[k].key);
+            assert(census.objects[n].key != NULL);
+            for (int o = 0; o < KNOWN_COUNT; o++) {
+                if (!strcmp(known[o], census.objects[n].key)) {
+                    census.objects[n].name = knownNames[o];
+                }
+            }
+            n += 1;
+        }
+    }
+    for (int o = 0; o < KNOWN_COUNT; o++) {
+        free(known[o]);
+    }
+    free(merged.slots);
+    arenaFree(&keys);
+    qsort(census.objects, census.count, sizeof(census_object_t), compareObjects);
+
+    return census;
+}
+
+/*
+ * Print the most common objects of a census
+ */
+void printCensus(census_t census, int limit) {
+    printf("%-12s %-10s %-6s %-6s %s\n", "Count", "Name", "Period", "Cells", "Code");
+    for (int k = 0; k < census.count && k < limit; k++) {
+        const census_object_t* o = &census.objects[k];
+        char period[16];
+        snprintf(period, sizeof(period), (o->period > 0 ? "%d" : "-"), o->period);
+        printf("%-12lld %-10s %-6s %-6d %s\n", o->count, (o->name != NULL ? o->name : "-"), period, o->cells, o->key);
+    }
+    if (census.count > limit) {
+        printf("... %d other objects\n", census.count - limit);
+    }
+}
+
+/*
+ * Write every object of a census as CSV
+ */
+void writeCensusCsv(census_t census, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "code,name,period,cells,count\n");
+    for (int k = 0; k < census.count; k++) {
+        const census_object_t* o = &census.objects[k];
+        fprintf(file, "%s,%s,%d,%d,%lld\n", o->key, (o->name != NULL ? o->name : ""), o->period, o->cells, o->count);
+    }
+    fclose(file);
+}
+
+/*
+ * Free memory of a census
+ */
+void freeCensus(census_t census) {
+    for (int k = 0; k < census.count; k++) {
+        free(census.objects[k].key);
+    }
+    free(census.objects);
+}
@@ -0,0 +1,101 @@
+/*
+ * Title    : Game of life / census
+ * Desc     : Headers for the census of the objects left by random soups
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _CENSUS_H_
+#define _CENSUS_H_
+
+#include <stdint.h>
+
+#define CENSUS_SOUP 16
+#define CENSUS_MARGIN 16
+#define CENSUS_MAX_GENERATIONS 20000
+#define CENSUS_SEED 20220801
+#define CENSUS_REPORT 30
+/*
+ * Largest period of the objects, they are run alone for as many generations
+ */
+#define CENSUS_MAX_PERIOD 256
+
+/*
+ * Kind of object found by the census
+ * key is the canonical code : the smallest code of the object over its phases,
+ * rotations and reflections, "WxH:" followed by its rows in hexadecimal (the
+ * lowest digit first). period is 0 for the objects which change when alone
+ */
+typedef struct census_object {
+    uint64_t hash;
+    char* key;
+    const char* name;
+    int period;
+    int cells;
+    long long count;
+} census_object_t;
+
+/*
+ * Results of a census, the objects by decreasing count
+ */
+typedef struct census {
+    census_object_t* objects;
+    int count;
+    long long soups;
+    long long unsettled;
+    long long plane;
+    long long total;
+    int threads;
+    double duration;
+} census_t;
+
+/*
+ * Run soups of width x height random cells at density, the soup k from seed + k,
+ * each one in the middle of CENSUS_MARGIN dead cells, until they are periodic
+ * (at most maxGens generations), then count the objects left
+ * The spaceships are counted and removed before they reach the border, the
+ * soups which still grow to it go on on the unbounded plane
+ * The soups are spread over threads (0 : as many as OpenMP uses), the results
+ * don't depend on their number
+ */
+census_t runCensus(int width, int height, long long soups, long long maxGens, double density, uint64_t seed, int threads);
+
+/*
+ * Print the most common objects of a census
+ */
+void printCensus(census_t census, int limit);
+
+/*
+ * Write every object of a census as CSV
+ */
+void writeCensusCsv(census_t census, const char* filename);
+
+/*
+ * Free memory of a census
+ */
+void freeCensus(census_t census);
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Title    : Game of life / counters
+ * Desc     : Hardware performance counters (perf_event_open) of the OpenMP threads
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "omp.h"
+#include "counters.h"
+
+static const char* counterNames[COUNTER_COUNT] = {
+    "cycles", "instructions", "L1d misses", "LLC misses", "branch misses", "task clock (ns)"
+};
+
+struct counters {
+    int threads;
+    int* fds;
+    int available[COUNTER_COUNT];
+};
+
+/*
+ * Fill the event of a counter
+ */
+static void counterEvent(int counter, struct perf_event_attr* attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (counter) {
+        case COUNTER_CYCLES:
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case COUNTER_INSTRUCTIONS:
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case COUNTER_L1_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                           | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case COUNTER_LLC_MISSES:
+            attr->config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case COUNTER_BRANCH_MISSES:
+            attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            attr->type = PERF_TYPE_SOFTWARE;
+            attr->config = PERF_COUNT_SW_TASK_CLOCK;
+            break;
+    }
+}
+
+/*
+ * Open the counters in every thread, return NULL with the reason printed
+ * if none of them is available
+ */
+counters_t* countersOpen(void) {
+    counters_t* counters = calloc(1, sizeof(counters_t));
+    assert(counters != NULL);
+    counters->threads = omp_get_max_threads();
+    counters->fds = malloc(counters->threads * COUNTER_COUNT * sizeof(int));
+    assert(counters->fds != NULL);
+    for (int k = 0; k < counters->threads * COUNTER_COUNT; k++) {
+        counters->fds[k] = -1;
+    }
+
+    // A counter is only available if every thread could open it
+    int failures[COUNTER_COUNT] = { 0 };
+    int error = 0;
+    #pragma omp parallel
+    {
+        int t = omp_get_thread_num();
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            struct perf_event_attr attr;
+            counterEvent(c, &attr);
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            counters->fds[t * COUNTER_COUNT + c] = fd;
+            if (fd < 0) {
+                #pragma omp atomic write
+                error = errno;
+                #pragma omp atomic
+                failures[c] += 1;
+            }
+        }
+    }
+
+    int count = 0;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        counters->available[c] = (failures[c] == 0);
+        count += counters->available[c];
+    }
+    if (count == 0) {
+        fprintf(stderr, "Performance counters unavailable : %s (see /proc/sys/kernel/perf_event_paranoid)\n", strerror(error));
+        countersClose(counters);
+        return NULL;
+    }
+    if (!counters->available[COUNTER_CYCLES]) {
+        fprintf(stderr, "Hardware counters unavailable : %s, only the task clock is read\n", strerror(error));
+    }
+    return counters;
+}
+
+/*
+ * Close the counters
+ */
+void countersClose(counters_t* counters) {
+    for (int k = 0; k < counters->threads * COUNTER_COUNT; k++) {
+        if (counters->fds[k] >= 0) {
+            close(counters->fds[k]);
+        }
+    }
+    free(counters->fds);
+    free(counters);
+}
+
+/*
+ * Return 1 if the counter is read
+ */
+int counterAvailable(counters_t* counters, int counter) {
+    return counters->available[counter];
+}
+
+/*
+ * Return the name of a counter
+ */
+const char* counterName(int counter) {
+    return counterNames[counter];
+}
+
+/*
+ * Read the current values, summed over the threads and scaled when the
+ * counters were multiplexed, 0 for the unavailable ones
+ */
+void countersRead(counters_t* counters, uint64_t* values) {
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        values[c] = 0;
+        if (!counters->available[c]) {
+            continue;
+        }
+        for (int t = 0; t < counters->threads; t++) {
+            // value, time enabled, time running
+            uint64_t data[3];
+            if (read(counters->fds[t * COUNTER_COUNT + c], data, sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            if (data[2] > 0 && data[2] < data[1]) {
+                data[0] = (uint64_t)((double)data[0] * data[1] / data[2]);
+            }
+            values[c] += data[0];
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Title    : Game of life / counters
+ * Desc     : Headers for the hardware performance counters
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+
+#include <stdint.h>
+
+#define COUNTER_CYCLES 0
+#define COUNTER_INSTRUCTIONS 1
+#define COUNTER_L1_MISSES 2
+#define COUNTER_LLC_MISSES 3
+#define COUNTER_BRANCH_MISSES 4
+#define COUNTER_TASK_CLOCK 5
+#define COUNTER_COUNT 6
+
+#define COUNTER_LINE 64
+
+/*
+ * Performance counters of the OpenMP threads (perf_event_open), user space only
+ * Each thread of the team opens its own counters, the values are the sums
+ * The counters the host doesn't provide (virtual machines, perf_event_paranoid)
+ * are left out, available tells which ones are read
+ */
+typedef struct counters counters_t;
+
+/*
+ * Open the counters in every thread, return NULL with the reason printed
+ * if none of them is available
+ */
+counters_t* countersOpen(void);
+
+/*
+ * Close the counters
+ */
+void countersClose(counters_t* counters);
+
+/*
+ * Return 1 if the counter is read
+ */
+int counterAvailable(counters_t* counters, int counter);
+
+/*
+ * Return the name of a counter
+ */
+const char* counterName(int counter);
+
+/*
+ * Read the current values, summed over the threads and scaled when the
+ * counters were multiplexed, 0 for the unavailable ones
+ */
+void countersRead(counters_t* counters, uint64_t* values);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Title    : Game of life / cycle
+ * Desc     : Detection of periodic boards with an incremental hash and a history table
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "cycle.h"
+#include "math.h"
+
+#define CYCLE_ROW_KEY 0x9e3779b97f4a7c15ULL
+#define CYCLE_KEY 0xd6e8feb86659fd93ULL
+
+/*
+ * Mixing function of splitmix64
+ */
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+ * High and low halves of the 128-bit product, xored
+ */
+static uint64_t fold(uint64_t a, uint64_t b) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (uint64_t)p ^ (uint64_t)(p >> 64);
+}
+
+/*
+ * Alocate the cycle detection of a board of width x height cells, every tile dirty
+ * The history remembers about the given number of generations, its size is
+ * rounded up to a power of 2, in sets of CYCLE_WAYS generations
+ */
+cycle_t allocCycle(int width, int height, int history) {
+    cycle_t cycle;
+    size_t size = CYCLE_WAYS;
+    while (size < (size_t)history) {
+        size *= 2;
+    }
+    cycle.mask = size / CYCLE_WAYS - 1;
+    cycle.rows = (height + CYCLE_TILE - 1) / CYCLE_TILE;
+    cycle.cols = (width + 63) / 64;
+    cycle.hashes = calloc(sizeof(uint64_t), (size_t)cycle.rows * cycle.cols);
+    cycle.sums = malloc((size_t)cycle.rows * cycle.cols * sizeof(uint64_t));
+    cycle.dirty = malloc((size_t)cycle.rows * cycle.cols);
+    cycle.history = malloc(size * sizeof(uint64_t));
+    cycle.generations = malloc(size * sizeof(long long));
+    assert(cycle.hashes != NULL && cycle.sums != NULL && cycle.dirty != NULL && cycle.history != NULL && cycle.generations != NULL);
+    cycle.hash = 0;
+    cycleDirtyAll(&cycle);
+    for (size_t k = 0; k < size; k++) {
+        cycle.generations[k] = -1;
+    }
+
+    memset(&cycle.candidate, 0, sizeof(cycle.candidate));
+    cycle.candidateHash = 0;
+    cycle.candidateGen = -1;
+    cycle.candidateEnd = -1;
+    cycle.period = 0;
+    cycle.found = -1;
+
+    return cycle;
+}
+
+/*
+ * Free memory of a cycle detection
+ */
+void freeCycle(cycle_t cycle) {
+    free(cycle.hashes);
+    free(cycle.sums);
+    free(cycle.dirty);
+    free(cycle.history);
+    free(cycle.generations);
+    if (cycle.candidate.data != NULL) {
+        freePackedBoard(cycle.candidate);
+    }
+}
+
+/*
+ * Mark a tile to be hashed again
+ */
+void cycleDirtyTile(cycle_t* cycle, int ti, int tj) {
+    cycle->dirty[idx(ti, tj, cycle->cols)] = 1;
+}
+
+/*
+ * Mark every tile to be hashed again
+ */
+void cycleDirtyAll(cycle_t* cycle) {
+    memset(cycle->dirty, 1, (size_t)cycle->rows * cycle->cols);
+}
+
+/*
+ * Hash the dirty tiles, the board hash is the xor of the tile hashes, each one
+ * salted with the position of its tile
+ * The rows of a tile are folded independently of each other and summed, so
+ * the board is read row by row and the products don't wait for each other
+ */
+static void hashTiles(cycle_t* cycle, packed_board_t board) {
+    uint64_t delta = 0;
+
+    #pragma omp parallel for schedule(dynamic) reduction(^:delta)
+    for (int ti = 0; ti < cycle->rows; ti++) {
+        int i1 = min((ti + 1) * CYCLE_TILE, board.height);
+        char* dirty = &cycle->dirty[idx(ti, 0, cycle->cols)];
+        uint64_t* sums = &cycle->sums[idx(ti, 0, cycle->cols)];
+        memset(sums, 0, cycle->cols * sizeof(uint64_t));
+
+        // Row by row, the words of a row are contiguous
+        for (int i = ti * CYCLE_TILE; i < i1; i++) {
+            const uint64_t* row = packedRow(board, i);
+            uint64_t key = CYCLE_ROW_KEY * (i + 1);
+            for (int tj = 0; tj < cycle->cols; tj++) {
+                if (dirty[tj]) {
+                    sums[tj] += fold(row[tj] ^ key, CYCLE_KEY);
+                }
+            }
+        }
+
+        for (int tj = 0; tj < cycle->cols; tj++) {
+            if (dirty[tj]) {
+                size_t t = idx(ti, tj, cycle->cols);
+                uint64_t h = mix(sums[tj] ^ mix(t + 1));
+                delta ^= cycle->hashes[t] ^ h;
+                cycle->hashes[t] = h;
+                dirty[tj] = 0;
+            }
+        }
+    }
+    cycle->hash ^= delta;
+}
+
+/*
+ * Return 1 if the cells of two boards of the same dimensions are the same
+ */
+static int sameCells(packed_board_t a, packed_board_t b) {
+    return !memcmp(packedRow(a, 0), packedRow(b, 0), (size_t)a.height * a.words * sizeof(uint64_t));
+}
+
+/*
+ * Hash the board of a generation, the tiles which changed must be dirty
+ * Return 1 once the board is known to be periodic, period and found are then
+ * set : found is the first generation whose board was seen period generations before
+ * A hash already in the history gives the largest possible period, the board
+ * is copied and compared with the next generations which have the same hash,
+ * the first one with the same cells gives the period. Without any after the
+ * candidate period, the match was a collision. A generation replaced in the
+ * history by a newer one is only found at the next repetition
+ */
+int cycleUpdate(cycle_t* cycle, packed_board_t board, long long generation) {
+    hashTiles(cycle, board);
+
+    if (cycle->candidateGen >= 0) {
+        if (cycle->hash == cycle->candidateHash && sameCells(board, cycle->candidate)) {
+            cycle->period = generation - cycle->candidateGen;
+            cycle->found = cycle->candidateGen;
+            return 1;
+        }
+        if (generation >= cycle->candidateEnd) {
+            cycle->candidateGen = -1;
+        }
+    }
+
+    // The oldest generation of the set is replaced
+    long long* generations = &cycle->generations[(cycle->hash & cycle->mask) * CYCLE_WAYS];
+    uint64_t* history = &cycle->history[(cycle->hash & cycle->mask) * CYCLE_WAYS];
+    int oldest = 0;
+    for (int w = 0; w < CYCLE_WAYS; w++) {
+        if (cycle->candidateGen < 0 && generations[w] >= 0 && history[w] == cycle->hash) {
+            if (cycle->candidate.data == NULL) {
+                cycle->candidate = allocPackedBoard(board.width, board.height);
+            }
+            memcpy(packedRow(cycle->candidate, 0), packedRow(board, 0), (size_t)board.height * board.words * sizeof(uint64_t));
+            cycle->candidateHash = cycle->hash;
+            cycle->candidateGen = generation;
+            cycle->candidateEnd = 2 * generation - generations[w];
+        }
+        if (generations[w] < generations[oldest]) {
+            oldest = w;
+        }
+    }
+    history[oldest] = cycle->hash;
+    generations[oldest] = generation;
+
+    return 0;
+}
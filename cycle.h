@@ -0,0 +1,106 @@
+/*
+ * Title    : Game of life / cycle
+ * Desc     : Headers for the detection of periodic boards
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _CYCLE_H_
+#define _CYCLE_H_
+
+#include <stdint.h>
+#include "board.h"
+
+/*
+ * Tiles of CYCLE_TILE rows of a word, like the tiles engine
+ */
+#define CYCLE_TILE 64
+/*
+ * Largest number of generations remembered by the history table
+ */
+#define CYCLE_MAX_HISTORY (1 << 24)
+/*
+ * Generations of the history which share a set of the table
+ */
+#define CYCLE_WAYS 4
+
+/*
+ * Hash of a board kept up to date from its changed tiles, and history of the
+ * hashes of the previous generations. A hash seen again gives a candidate
+ * period, confirmed by comparing a copy of the board with the next generations
+ */
+typedef struct cycle {
+    uint64_t* hashes;
+    uint64_t* sums;
+    char* dirty;
+    int rows;
+    int cols;
+    uint64_t hash;
+
+    // Set-associative table, a newer generation replaces the oldest one of its set
+    uint64_t* history;
+    long long* generations;
+    size_t mask;
+
+    // Copy of the board being confirmed, no data when there isn't any
+    packed_board_t candidate;
+    uint64_t candidateHash;
+    long long candidateGen;
+    long long candidateEnd;
+
+    long long period;
+    long long found;
+} cycle_t;
+
+/*
+ * Alocate the cycle detection of a board of width x height cells, every tile dirty
+ * The history remembers about the given number of generations
+ */
+cycle_t allocCycle(int width, int height, int history);
+
+/*
+ * Free memory of a cycle detection
+ */
+void freeCycle(cycle_t cycle);
+
+/*
+ * Mark a tile to be hashed again
+ */
+void cycleDirtyTile(cycle_t* cycle, int ti, int tj);
+
+/*
+ * Mark every tile to be hashed again
+ */
+void cycleDirtyAll(cycle_t* cycle);
+
+/*
+ * Hash the board of a generation, the tiles which changed must be dirty
+ * Return 1 once the board is known to be periodic, period and found are then
+ * set : found is the first generation whose board was seen period generations before
+ */
+int cycleUpdate(cycle_t* cycle, packed_board_t board, long long generation);
+
+#endif
@@ -29,10 +29,12 @@ SOFTWARE.
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <SDL/SDL.h>
 #include <SDL/SDL_ttf.h>
 #include "display.h"
 #include "board.h"
+#include "viewport.h"
 #include "math.h"
 
 #define TEXT_MARGIN 18
@@ -47,12 +49,26 @@ SOFTWARE.
 #define PALETTE_SIZE 256
 #define CURSOR_SIZE 0
 #define HEADER_SIZE 150
+#define MAX_DIRTY 256
    
 SDL_Surface *screen = NULL;
 int cellSize = 0;
-int screenSize = 0;
+int screenWidth = 0;
 SDL_Rect btnRect;
 
+// Part of the board shown, and whether the screen holds a drawn frame
+view_t view;
+int boardWidth = 0;
+int boardHeight = 0;
+int shownValid = 0;
+
+// Regions drawn since the last present
+SDL_Rect dirtyRects[MAX_DIRTY];
+int dirtyCount = 0;
+
+// Screen color of each value of the view : density from empty to cell, and back
+Uint8 viewColors[256];
+
 SDL_Color colors[PALETTE_SIZE];
 TTF_Font* fontS;
 TTF_Font* fontM;
@@ -66,9 +82,9 @@ Uint32 borderColor;
 
 /**
  * Convert the screen coordinate to the array indexes
- * Return -1 if outOfBound, -2 if button pressed
+ * Return -1 if outOfBound or zoomed out, -2 if button pressed
  */
-Point getPointFromScreen(int x, int y, int size) {
+Point getPointFromScreen(int x, int y, int width, int height) {
     Point p = {0, 0};
 
     // Button
@@ -79,10 +95,16 @@ Point getPointFromScreen(int x, int y, int size) {
         return p;
     }
 
-    p.i = y / (cellSize + MARGIN);
-    p.j = x / (cellSize + MARGIN);
+    // Cells can only be edited when there is at least one pixel per cell
+    x -= MARGIN;
+    y -= MARGIN;
+    if (view.zoom > 0 && x >= 0 && y >= 0) {
+        p.i = view.i0 + y / view.zoom;
+        p.j = view.j0 + x / view.zoom;
+    }
 
-    if (p.i >= size || p.j >= size) {
+    if (view.zoom <= 0 || x < 0 || y < 0 || x >= view.width || y >= view.height
+        || p.i >= height || p.j >= width) {
         p.i = -1;
         p.j = -1;
     }
@@ -112,28 +134,47 @@ void initVariables() {
 }
 
 /**
- * Choose the optimal cell size depending on the board size
+ * Choose the optimal cell size depending on the board dimensions, and the view
+ * Boards too large for the screen are zoomed out to fit, a pixel per several cells
  */
-void setCellSize(int size) {
+void setCellSize(int width, int height) {
     const SDL_VideoInfo* info = SDL_GetVideoInfo();
-    int width = info->current_w;
-    int height = info->current_h;
-    int mins = min(height - HEADER_SIZE, width);
+    int mins = min(info->current_h - HEADER_SIZE, info->current_w - TEXT_SIZE);
+
+    cellSize = min(max(mins / max(width, height), CELL_MIN_SIZE), CELL_MAX_SIZE);
+    view = fitView(width, height, max(mins, WINDOW_MIN_SIZE) - MARGIN, cellSize + MARGIN);
+}
 
-    cellSize = min(max(mins / size, CELL_MIN_SIZE), CELL_MAX_SIZE);
+/**
+ * Add a region to push at the next present, the whole screen when the list is full
+ */
+static void addDirty(int x, int y, int w, int h) {
+    if (dirtyCount == MAX_DIRTY) {
+        dirtyRects[0].x = 0;
+        dirtyRects[0].y = 0;
+        dirtyRects[0].w = screen->w;
+        dirtyRects[0].h = screen->h;
+        dirtyCount = 1;
+    } else {
+        SDL_Rect rect = { x, y, w, h };
+        dirtyRects[dirtyCount++] = rect;
+    }
 }
 
 /**
  * Initialize the display window
  */
-void initScreen(int size) {
+void initScreen(int width, int height) {
     // Create screen
     SDL_Init(SDL_INIT_VIDEO);
-    setCellSize(size);
-
-    screenSize = size * (cellSize + MARGIN) + MARGIN;
-    int windowHeight = max(screenSize, WINDOW_MIN_SIZE);
-    screen = SDL_SetVideoMode(screenSize + TEXT_SIZE, windowHeight, 8, SDL_HWSURFACE | SDL_DOUBLEBUF);
+    setCellSize(width, height);
+
+    boardWidth = width;
+    boardHeight = height;
+    screenWidth = view.width + MARGIN;
+    int windowHeight = max(view.height + MARGIN, WINDOW_MIN_SIZE);
+    // Single buffered, the drawn regions are pushed with SDL_UpdateRects
+    screen = SDL_SetVideoMode(screenWidth + TEXT_SIZE, windowHeight, 8, SDL_SWSURFACE);
     SDL_WM_SetCaption("Game of Life", NULL);
 
     if(TTF_Init() == -1)
@@ -149,13 +190,13 @@ void initScreen(int size) {
     SDL_FillRect(screen, NULL, backColor);
 
     SDL_Rect rect;
-    rect.x = screenSize;
+    rect.x = screenWidth;
     rect.y = 0;
     rect.w = TEXT_SIZE;
     rect.h = windowHeight;
     SDL_FillRect(screen, &rect, backColor);
 
-    rect.x = screenSize + TEXT_MARGIN;
+    rect.x = screenWidth + TEXT_MARGIN;
     rect.y = windowHeight - TEXT_MARGIN - BTN_HEIGHT;
     rect.w = TEXT_SIZE - 2*TEXT_MARGIN;
     rect.h = BTN_HEIGHT;
@@ -171,7 +212,7 @@ void initScreen(int size) {
     SDL_Surface* text = TTF_RenderText_Solid(fontS, "Save board", colors[10]);
     SDL_BlitSurface(text, NULL, screen, &rect);
 
-    rect.x = screenSize + TEXT_MARGIN;
+    rect.x = screenWidth + TEXT_MARGIN;
     rect.y = TEXT_MARGIN;
     SDL_Surface* text1 = TTF_RenderText_Solid(fontS, "Generation", colors[75]);
     SDL_BlitSurface(text1, NULL, screen, &rect);
@@ -183,39 +224,90 @@ void initScreen(int size) {
     SDL_FreeSurface(text);
     SDL_FreeSurface(text1);
     SDL_FreeSurface(text2);
+
+    for (int v = 0; v < 256; v++) {
+        int gray = viewGray(v);
+        viewColors[v] = SDL_MapRGB(screen->format, gray, gray, gray);
+    }
+
+    shownValid = 0;
+
+    addDirty(0, 0, screen->w, screen->h);
 }
 
 /**
- * Update the screen with the current game state
+ * Return the part of the board shown
  */
-void updateScreen(board_t board) {
-    SDL_Rect position;
-    position.x = MARGIN;
-    position.y = MARGIN;
-    
-    for (int i = 0; i < board.size; i++) {
-        for (int j = 0; j < board.size; j++) {
-            SDL_Surface* cell = SDL_CreateRGBSurface(SDL_HWSURFACE, cellSize, cellSize, 8, 0, 0, 0, 0);
-            SDL_SetPalette(cell, SDL_LOGPAL|SDL_PHYSPAL, colors, 0, PALETTE_SIZE);
-            SDL_FillRect(cell, NULL, (board.data[idx(i, j, board.size)] == 0 ? emptyColor: cellColor));
-            SDL_BlitSurface(cell, NULL, screen, &position);
-
-            SDL_FreeSurface(cell);
-            position.x += cellSize + MARGIN;
+view_t screenView() {
+    return view;
+}
+
+/**
+ * Zoom in or out around the screen coordinate (x, y)
+ */
+void zoomScreen(int in, int x, int y) {
+    x = min(max(x - MARGIN, 0), view.width - 1);
+    y = min(max(y - MARGIN, 0), view.height - 1);
+    view = zoomView(view, boardWidth, boardHeight, in, x, y);
+}
+
+/**
+ * Move the view by (di, dj) quarters of it
+ */
+void panScreen(int di, int dj) {
+    view = panView(view, boardWidth, boardHeight, di, dj);
+}
+
+/**
+ * Update the screen with the pixels of the view rendered by renderView
+ * Only the lines flagged in lines are written and pushed, all of them when
+ * lines is NULL
+ */
+void updateScreenView(const unsigned char* pixels, const unsigned char* lines) {
+    if (SDL_MUSTLOCK(screen)) {
+        SDL_LockSurface(screen);
+    }
+
+    int first = -1;
+    for (int y = 0; y <= view.height; y++) {
+        size_t offset = (size_t)y * view.width;
+        if (y == view.height || (shownValid && lines != NULL && !lines[y])) {
+            if (first >= 0) {
+                addDirty(MARGIN, MARGIN + first, view.width, y - first);
+                first = -1;
+            }
+            continue;
         }
-        position.y += cellSize + MARGIN;
-        position.x = MARGIN;
+
+        Uint8* line = (Uint8*)screen->pixels + (MARGIN + y) * screen->pitch + MARGIN;
+        for (int x = 0; x < view.width; x++) {
+            line[x] = viewColors[pixels[offset + x]];
+        }
+        first = (first < 0 ? y : first);
     }
+    shownValid = 1;
 
-    SDL_Flip(screen);
+    if (SDL_MUSTLOCK(screen)) {
+        SDL_UnlockSurface(screen);
+    }
 }
 
 /**
- * Update the texts in the window
+ * Push the regions drawn since the last present to the window
  */
-void updateTexts(int running, int wait, int generation) {
+void presentScreen() {
+    if (dirtyCount > 0) {
+        SDL_UpdateRects(screen, dirtyCount, dirtyRects);
+        dirtyCount = 0;
+    }
+}
+
+/**
+ * Update the texts in the window, a wait of 0 is shown as unlimited
+ */
+void updateTexts(int running, int wait, long long generation) {
     SDL_Rect rect;
-    rect.x = screenSize;
+    rect.x = screenWidth;
     rect.y = TEXT_MARGIN + LINE_MARGIN;
     rect.w = TEXT_SIZE;
     rect.h = LINE_MARGIN;
@@ -226,16 +318,20 @@ void updateTexts(int running, int wait, int generation) {
     SDL_FillRect(screen, &rect, backColor);
 
     SDL_Rect position;
-    position.x = screenSize + TEXT_MARGIN;
+    position.x = screenWidth + TEXT_MARGIN;
     position.y = TEXT_MARGIN + LINE_MARGIN;
 
-    char str[15];
-    sprintf(str, "%d", generation);
+    char str[24];
+    sprintf(str, "%lld", generation);
     SDL_Surface* text = TTF_RenderText_Solid(fontM, str, colors[0]);
     SDL_BlitSurface(text, NULL, screen, &position);
     position.y += 3 * LINE_MARGIN;
 
-    sprintf(str, "%dms", wait);
+    if (wait == 0) {
+        sprintf(str, "unlimited");
+    } else {
+        sprintf(str, "%dms", wait);
+    }
     SDL_Surface* text1 = TTF_RenderText_Solid(fontM, str, colors[0]);
     SDL_BlitSurface(text1, NULL, screen, &position);
     position.y += 2 * LINE_MARGIN;
@@ -246,7 +342,7 @@ void updateTexts(int running, int wait, int generation) {
         SDL_FreeSurface(text2);
     }
 
-    SDL_Flip(screen);
+    addDirty(screenWidth, 0, TEXT_SIZE, screen->h);
     SDL_FreeSurface(text);
     SDL_FreeSurface(text1);
 }
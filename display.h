@@ -32,6 +32,7 @@ SOFTWARE.
 #define _DISPLAY_H_
 
 #include "board.h"
+#include "viewport.h"
 
 typedef struct Point {
     int i;
@@ -40,21 +41,39 @@ typedef struct Point {
 
 /**
  * Convert the screen coordinate to the array indexes
- * Return -1 if outOfBound, -2 if button pressed
+ * Return -1 if outOfBound or zoomed out, -2 if button pressed
  */
-Point getPointFromScreen(int x, int y, int size);
+Point getPointFromScreen(int x, int y, int width, int height);
 /**
  * Initialize the display window
  */
-void initScreen(int size);
+void initScreen(int width, int height);
 /**
- * Update the screen with the current game state
+ * Return the part of the board shown
  */
-void updateScreen(board_t board);
+view_t screenView();
 /**
- * Update the texts in the window
+ * Zoom in or out around the screen coordinate (x, y)
  */
-void updateTexts(int running, int wait, int generation);
+void zoomScreen(int in, int x, int y);
+/**
+ * Move the view by (di, dj) quarters of it
+ */
+void panScreen(int di, int dj);
+/**
+ * Update the screen with the pixels of the view rendered by renderView
+ * Only the lines flagged in lines are written and pushed, all of them when
+ * lines is NULL
+ */
+void updateScreenView(const unsigned char* pixels, const unsigned char* lines);
+/**
+ * Push the regions drawn since the last present to the window
+ */
+void presentScreen();
+/**
+ * Update the texts in the window, a wait of 0 is shown as unlimited
+ */
+void updateTexts(int running, int wait, long long generation);
 /**
  * Close the window and free memory
  */
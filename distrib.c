@@ -0,0 +1,688 @@
+/*
+ * Title    : Game of life / distrib
+ * Desc     : Board split in strips of rows between processes, with halo exchange over sockets
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "board.h"
+#include "distrib.h"
+#include "automata.h"
+#include "boundary.h"
+#include "binary.h"
+#include "pattern.h"
+#include "rule.h"
+#include "math.h"
+
+#define DISTRIB_CHUNK (1 << 20)
+#define DISTRIB_CONNECT_TRIES 600
+#define DISTRIB_CONNECT_WAIT_NS 100000000
+#define MAX_TRANSFERS 4
+
+/*
+ * Bytes to send to or to receive from a link
+ */
+typedef struct transfer {
+    int fd;
+    char* data;
+    size_t length;
+    int send;
+} transfer_t;
+
+/*
+ * Sent down the chain of processes before the rows of the board
+ */
+typedef struct strip_header {
+    int32_t width;
+    int32_t height;
+    uint32_t birth;
+    uint32_t survival;
+    int64_t generation;
+} strip_header_t;
+
+struct distrib {
+    int rank;
+    int procs;
+    int up;
+    int down;
+    pid_t* children;
+
+    // Halo exchange thread, runs the transfers while the interior is computed
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    transfer_t transfers[MAX_TRANSFERS];
+    int count;
+    int pending;
+    int quit;
+};
+
+/*
+ * Print an error of this process and exit, the others lose their link and exit too
+ */
+static void distribError(distrib_t* d, const char* msg) {
+    fprintf(stderr, "Process %d: %s\n", d->rank, msg);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * Run the transfers at the same time until they are all done, so two
+ * processes sending to each other never wait on a full socket buffer
+ */
+static void runTransfers(distrib_t* d, transfer_t* transfers, int count) {
+    struct pollfd fds[MAX_TRANSFERS];
+    transfer_t* polled[MAX_TRANSFERS];
+
+    while (1) {
+        int n = 0;
+        for (int k = 0; k < count; k++) {
+            if (transfers[k].length > 0) {
+                fds[n].fd = transfers[k].fd;
+                fds[n].events = (transfers[k].send ? POLLOUT : POLLIN);
+                polled[n++] = &transfers[k];
+            }
+        }
+        if (n == 0) {
+            return;
+        }
+        if (poll(fds, n, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            distribError(d, strerror(errno));
+        }
+
+        for (int k = 0; k < n; k++) {
+            if (fds[k].revents == 0) {
+                continue;
+            }
+            transfer_t* t = polled[k];
+            ssize_t done = (t->send ? send(t->fd, t->data, t->length, MSG_NOSIGNAL)
+                                    : recv(t->fd, t->data, t->length, 0));
+            if (done < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            if (done <= 0) {
+                distribError(d, "connection lost");
+            }
+            t->data += done;
+            t->length -= done;
+        }
+    }
+}
+
+/*
+ * Send or receive a block of bytes on a link
+ */
+static void transferAll(distrib_t* d, int fd, void* data, size_t length, int send) {
+    transfer_t t = { fd, data, length, send };
+    runTransfers(d, &t, 1);
+}
+
+/*
+ * Pass length bytes from a link to another, a chunk at a time
+ */
+static void forwardBytes(distrib_t* d, int from, int to, size_t length) {
+    char* buffer = malloc(DISTRIB_CHUNK);
+    assert(buffer != NULL);
+    while (length > 0) {
+        size_t chunk = min(length, (size_t)DISTRIB_CHUNK);
+        transferAll(d, from, buffer, chunk, 0);
+        transferAll(d, to, buffer, chunk, 1);
+        length -= chunk;
+    }
+    free(buffer);
+}
+
+/*
+ * Exchange thread, waits for pending transfers and runs them
+ */
+static void* exchangeLoop(void* arg) {
+    distrib_t* d = arg;
+
+    pthread_mutex_lock(&d->lock);
+    while (1) {
+        while (!d->pending && !d->quit) {
+            pthread_cond_wait(&d->cond, &d->lock);
+        }
+        if (!d->pending) {
+            break;
+        }
+        pthread_mutex_unlock(&d->lock);
+
+        runTransfers(d, d->transfers, d->count);
+
+        pthread_mutex_lock(&d->lock);
+        d->pending = 0;
+        pthread_cond_broadcast(&d->cond);
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    return NULL;
+}
+
+/*
+ * Hand transfers over to the exchange thread
+ */
+static void startExchange(distrib_t* d, const transfer_t* transfers, int count) {
+    pthread_mutex_lock(&d->lock);
+    memcpy(d->transfers, transfers, count * sizeof(transfer_t));
+    d->count = count;
+    d->pending = 1;
+    pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+}
+
+/*
+ * Wait for the transfers of the exchange thread to be done
+ */
+static void waitExchange(distrib_t* d) {
+    pthread_mutex_lock(&d->lock);
+    while (d->pending) {
+        pthread_cond_wait(&d->cond, &d->lock);
+    }
+    pthread_mutex_unlock(&d->lock);
+}
+
+/*
+ * Make the links non-blocking and start the exchange thread
+ */
+static distrib_t* startDistrib(distrib_t* d) {
+    int links[2] = { d->up, d->down };
+    for (int k = 0; k < 2; k++) {
+        if (links[k] >= 0) {
+            fcntl(links[k], F_SETFL, fcntl(links[k], F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->cond, NULL);
+    int err = pthread_create(&d->thread, NULL, exchangeLoop, d);
+    assert(err == 0);
+    return d;
+}
+
+/*
+ * Return a new group of processes, not linked yet
+ */
+static distrib_t* allocDistrib(int rank, int procs) {
+    distrib_t* d = calloc(1, sizeof(distrib_t));
+    assert(d != NULL);
+    d->rank = rank;
+    d->procs = procs;
+    d->up = -1;
+    d->down = -1;
+    return d;
+}
+
+/*
+ * Fork the processes 1 to procs-1, linked by socket pairs
+ * Return in each process, with its rank
+ * The link k joins the process k (its down end) to the process k+1 (its up end),
+ * the last link wraps from the last process to the process 0
+ */
+distrib_t* distribFork(int procs, int wrap) {
+    distrib_t* d = allocDistrib(0, procs);
+    int (*links)[2] = malloc(procs * sizeof(*links));
+    assert(links != NULL);
+    for (int k = 0; k < procs; k++) {
+        links[k][0] = links[k][1] = -1;
+        if ((k < procs - 1 || wrap) && procs > 1 && socketpair(AF_UNIX, SOCK_STREAM, 0, links[k]) < 0) {
+            distribError(d, strerror(errno));
+        }
+    }
+
+    // The buffered texts would be printed by every process
+    fflush(stdout);
+    d->children = calloc(procs, sizeof(pid_t));
+    assert(d->children != NULL);
+    for (int r = 1; r < procs; r++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            distribError(d, strerror(errno));
+        } else if (pid == 0) {
+            d->rank = r;
+            free(d->children);
+            d->children = NULL;
+            break;
+        }
+        d->children[r] = pid;
+    }
+
+    // Keep the ends of this process, close the others
+    int r = d->rank;
+    for (int k = 0; k < procs; k++) {
+        for (int end = 0; end < 2; end++) {
+            int fd = links[k][end];
+            if (fd < 0) {
+                continue;
+            } else if (end == 0 && k == r) {
+                d->down = fd;
+            } else if (end == 1 && (k + 1) % procs == r) {
+                d->up = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    free(links);
+
+    return startDistrib(d);
+}
+
+/*
+ * Split "host:port" in place, return the port or NULL
+ */
+static char* splitPeer(char* peer) {
+    char* colon = strrchr(peer, ':');
+    if (colon == NULL) {
+        return NULL;
+    }
+    *colon = '\0';
+    return colon + 1;
+}
+
+/*
+ * Return a socket listening on the port, on every interface
+ */
+static int listenOn(distrib_t* d, const char* port) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(NULL, port, &hints, &res) != 0) {
+        distribError(d, "invalid port");
+    }
+
+    int one = 1;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+            || bind(fd, res->ai_addr, res->ai_addrlen) < 0 || listen(fd, 1) < 0) {
+        distribError(d, strerror(errno));
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+/*
+ * Return a socket connected to host:port, tried again while the other process starts
+ */
+static int connectTo(distrib_t* d, const char* host, const char* port) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0) {
+        distribError(d, "unknown host");
+    }
+
+    for (int tries = 0; tries < DISTRIB_CONNECT_TRIES; tries++) {
+        int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (fd < 0) {
+            distribError(d, strerror(errno));
+        }
+        if (connect(fd, res->ai_addr, res->ai_addrlen) == 0) {
+            freeaddrinfo(res);
+            return fd;
+        }
+        close(fd);
+        struct timespec wait = { 0, DISTRIB_CONNECT_WAIT_NS };
+        nanosleep(&wait, NULL);
+    }
+    distribError(d, "can't connect to the next process");
+    return -1;
+}
+
+/*
+ * Return the number of processes of a list of peers ("host:port,host:port")
+ */
+int distribPeers(const char* peers) {
+    int procs = 0;
+    for (const char* c = peers; *c != '\0'; c++) {
+        // The empty entries are skipped, like strtok does
+        procs += (*c != ',' && (c == peers || c[-1] == ','));
+    }
+    return procs;
+}
+
+/*
+ * Connect this process to the others over TCP, peers is the list of the
+ * "host:port" of every process, in the order of the strips
+ * Each process listens on its port for the process above it, then connects to
+ * the process below it
+ */
+distrib_t* distribConnect(const char* peers, int rank, int wrap) {
+    char* list = strdup(peers);
+    char* hosts[DISTRIB_MAX_PROCS];
+    char* ports[DISTRIB_MAX_PROCS];
+    int procs = 0;
+    char* save = NULL;
+    distrib_t* d = allocDistrib(rank, 0);
+    assert(list != NULL);
+
+    for (char* peer = strtok_r(list, ",", &save); peer != NULL; peer = strtok_r(NULL, ",", &save)) {
+        if (procs == DISTRIB_MAX_PROCS || (ports[procs] = splitPeer(peer)) == NULL) {
+            distribError(d, "invalid list of peers");
+        }
+        hosts[procs++] = peer;
+    }
+    if (rank >= procs) {
+        distribError(d, "rank outside of the list of peers");
+    }
+    d->procs = procs;
+
+    int hasUp = (rank > 0 || (wrap && procs > 1));
+    int hasDown = (rank < procs - 1 || (wrap && procs > 1));
+    int listener = (hasUp ? listenOn(d, ports[rank]) : -1);
+    if (hasDown) {
+        d->down = connectTo(d, hosts[(rank + 1) % procs], ports[(rank + 1) % procs]);
+    }
+    if (hasUp) {
+        d->up = accept(listener, NULL, NULL);
+        if (d->up < 0) {
+            distribError(d, strerror(errno));
+        }
+        close(listener);
+    }
+
+    // The halo rows are small messages, sent as soon as they are ready
+    int one = 1;
+    int links[2] = { d->up, d->down };
+    for (int k = 0; k < 2; k++) {
+        if (links[k] >= 0) {
+            setsockopt(links[k], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+    free(list);
+
+    return startDistrib(d);
+}
+
+/*
+ * Return the rank of this process, 0 for the first strip
+ */
+int distribRank(distrib_t* d) {
+    return d->rank;
+}
+
+/*
+ * Return the number of processes
+ */
+int distribProcs(distrib_t* d) {
+    return d->procs;
+}
+
+/*
+ * Close the links, the process 0 waits for the processes it forked
+ * Return the number of processes which failed
+ */
+int distribFree(distrib_t* d) {
+    pthread_mutex_lock(&d->lock);
+    d->quit = 1;
+    pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    pthread_join(d->thread, NULL);
+    pthread_mutex_destroy(&d->lock);
+    pthread_cond_destroy(&d->cond);
+
+    if (d->up >= 0) {
+        close(d->up);
+    }
+    if (d->down >= 0) {
+        close(d->down);
+    }
+
+    int failures = 0;
+    if (d->children != NULL) {
+        for (int r = 1; r < d->procs; r++) {
+            int status;
+            if (waitpid(d->children[r], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failures += 1;
+            }
+        }
+        free(d->children);
+    }
+    free(d);
+    return failures;
+}
+
+/*
+ * Return the first row of the strip of a process
+ */
+static int firstRow(int height, int procs, int rank) {
+    return (int)((long long)height * rank / procs);
+}
+
+/*
+ * Send its strip of the board to each process, down the chain of processes
+ * Only the process 0 gives the board and the generation, the others get them
+ * with the rule
+ * Each process keeps its rows and passes the rows below them on, so the board
+ * is only read once, by the process 0
+ */
+strip_t scatterStrips(distrib_t* d, packed_board_t board, long long generation) {
+    strip_header_t header;
+    if (d->rank == 0) {
+        if (board.height < d->procs) {
+            distribError(d, "fewer rows than processes");
+        }
+        rule_t rule = getRule();
+        header.width = board.width;
+        header.height = board.height;
+        header.birth = rule.birth;
+        header.survival = rule.survival;
+        header.generation = generation;
+    } else {
+        transferAll(d, d->up, &header, sizeof(header), 0);
+        rule_t rule = { header.birth, header.survival };
+        setRule(rule);
+    }
+    if (d->rank < d->procs - 1) {
+        transferAll(d, d->down, &header, sizeof(header), 1);
+    }
+
+    strip_t strip;
+    strip.width = header.width;
+    strip.height = header.height;
+    strip.i0 = firstRow(header.height, d->procs, d->rank);
+    strip.generation = header.generation;
+    int i1 = firstRow(header.height, d->procs, d->rank + 1);
+    strip.curr = allocPackedBoard(header.width, i1 - strip.i0);
+    strip.next = allocPackedBoard(header.width, i1 - strip.i0);
+
+    size_t rowLength = strip.curr.words * sizeof(uint64_t);
+    size_t below = (size_t)(header.height - i1) * rowLength;
+    if (d->rank == 0) {
+        memcpy(packedRow(strip.curr, 0), packedRow(board, 0), (size_t)strip.curr.height * rowLength);
+        if (below > 0) {
+            transferAll(d, d->down, packedRow(board, i1), below, 1);
+        }
+    } else {
+        transferAll(d, d->up, packedRow(strip.curr, 0), (size_t)strip.curr.height * rowLength, 0);
+        if (below > 0) {
+            forwardBytes(d, d->up, d->down, below);
+        }
+    }
+
+    return strip;
+}
+
+/*
+ * Advance the strip by one generation
+ * The edge rows are sent to the neighbours and their edge rows received as
+ * halo rows by the exchange thread, while the interior rows are computed
+ */
+static void stepStrip(distrib_t* d, strip_t* strip) {
+    packed_board_t curr = strip->curr;
+    int rows = curr.height;
+
+    if (d->procs == 1) {
+        fillPackedHalo(curr);
+        calculateRowsPacked(curr, strip->next, 0, rows);
+    } else {
+        size_t length = curr.words * sizeof(uint64_t);
+        transfer_t transfers[MAX_TRANSFERS];
+        int count = 0;
+        if (d->up >= 0) {
+            transfers[count++] = (transfer_t){ d->up, (char*)packedRow(curr, 0), length, 1 };
+            transfers[count++] = (transfer_t){ d->up, (char*)packedRow(curr, -1), length, 0 };
+        }
+        if (d->down >= 0) {
+            transfers[count++] = (transfer_t){ d->down, (char*)packedRow(curr, rows - 1), length, 1 };
+            transfers[count++] = (transfer_t){ d->down, (char*)packedRow(curr, rows), length, 0 };
+        }
+
+        startExchange(d, transfers, count);
+        calculateRowsPacked(curr, strip->next, 1, rows - 1);
+        waitExchange(d);
+
+        fillStripHalo(curr, d->rank == 0, d->rank == d->procs - 1);
+        calculateRowsPacked(curr, strip->next, 0, 1);
+        if (rows > 1) {
+            calculateRowsPacked(curr, strip->next, rows - 1, rows);
+        }
+    }
+
+    strip->curr = strip->next;
+    strip->next = curr;
+    strip->generation += 1;
+}
+
+/*
+ * Advance the strips by n generations
+ * The halo rows are exchanged while the interior rows are computed
+ */
+void stepStrips(distrib_t* d, strip_t* strip, long long n) {
+    for (long long g = 0; g < n; g++) {
+        stepStrip(d, strip);
+    }
+}
+
+/*
+ * Return the number of living cells of the board to the process 0, the
+ * population of its own strip and the strips below to the others
+ * The sum goes up the chain of processes
+ */
+long long stripsPopulation(distrib_t* d, strip_t strip) {
+    int64_t population = packedPopulation(strip.curr);
+    if (d->rank < d->procs - 1) {
+        int64_t below;
+        transferAll(d, d->down, &below, sizeof(below), 0);
+        population += below;
+    }
+    if (d->rank > 0) {
+        transferAll(d, d->up, &population, sizeof(population), 1);
+    }
+    return population;
+}
+
+/*
+ * Write the whole board to a file from the process 0, the format is given by
+ * the extension, nothing is written if it is empty. Every process calls it,
+ * only the filename of the process 0 is used. A binary board is written while
+ * the strips arrive, the other formats gather the board in memory first
+ * Each process sends its rows then passes the rows below them on, up the
+ * chain of processes
+ */
+void gatherStrips(distrib_t* d, strip_t strip, const char* filename) {
+    int rows = strip.curr.height;
+    int below = strip.height - strip.i0 - rows;
+    size_t rowLength = strip.curr.words * sizeof(uint64_t);
+
+    // The process 0 tells the others whether the board is saved
+    int32_t save = (d->rank == 0 ? strcmp(filename, "") != 0 : 0);
+    if (d->rank > 0) {
+        transferAll(d, d->up, &save, sizeof(save), 0);
+    }
+    if (d->rank < d->procs - 1) {
+        transferAll(d, d->down, &save, sizeof(save), 1);
+    }
+    if (!save) {
+        return;
+    }
+
+    if (d->rank > 0) {
+        transferAll(d, d->up, packedRow(strip.curr, 0), (size_t)rows * rowLength, 1);
+        if (below > 0) {
+            forwardBytes(d, d->down, d->up, (size_t)below * rowLength);
+        }
+        return;
+    }
+
+    if (patternFormat(filename, NULL, 0) == FORMAT_BINARY) {
+        binary_writer_t writer = beginBinaryBoard(strip.width, strip.height, strip.generation, filename);
+        writeBinaryRows(&writer, packedRow(strip.curr, 0), rows);
+
+        int chunk = max(DISTRIB_CHUNK / (int)rowLength, 1);
+        uint64_t* buffer = malloc((size_t)chunk * rowLength);
+        assert(buffer != NULL);
+        for (int i = 0; i < below; i += chunk) {
+            int n = min(chunk, below - i);
+            transferAll(d, d->down, buffer, (size_t)n * rowLength, 0);
+            writeBinaryRows(&writer, buffer, n);
+        }
+        free(buffer);
+        endBinaryBoard(&writer);
+    } else {
+        packed_board_t packed = allocPackedBoard(strip.width, strip.height);
+        memcpy(packedRow(packed, 0), packedRow(strip.curr, 0), (size_t)rows * rowLength);
+        if (below > 0) {
+            transferAll(d, d->down, packedRow(packed, rows), (size_t)below * rowLength, 0);
+        }
+
+        board_t board = allocBoard(strip.width, strip.height);
+        unpackBoard(packed, board);
+        saveBoardAs(board, filename);
+        freeBoard(board);
+        freePackedBoard(packed);
+    }
+}
+
+/*
+ * Free memory of a strip
+ */
+void freeStrip(strip_t strip) {
+    freePackedBoard(strip.curr);
+    freePackedBoard(strip.next);
+}
@@ -0,0 +1,124 @@
+/*
+ * Title    : Game of life / distrib
+ * Desc     : Board split in strips of rows between processes, with halo exchange over sockets
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _DISTRIB_H_
+#define _DISTRIB_H_
+
+#include "board.h"
+
+#define DISTRIB_MAX_PROCS 256
+
+/*
+ * Group of processes sharing a board, each one owning a strip of whole rows
+ * (the process 0 the first one), linked by a socket to the processes of the
+ * strips above and below it. The links wrap around for the torus and the
+ * Klein bottle. The processes are forked on this host, or started on several
+ * hosts and connected over TCP
+ */
+typedef struct distrib distrib_t;
+
+/*
+ * Strip of the rows i0 to i0 + curr.height (excluded) of a board of
+ * width x height cells, its halo rows are the edge rows of the strips around it
+ */
+typedef struct strip {
+    packed_board_t curr;
+    packed_board_t next;
+    int width;
+    int height;
+    int i0;
+    long long generation;
+} strip_t;
+
+/*
+ * Fork the processes 1 to procs-1, linked by socket pairs
+ * Return in each process, with its rank
+ */
+distrib_t* distribFork(int procs, int wrap);
+
+/*
+ * Return the number of processes of a list of peers ("host:port,host:port")
+ */
+int distribPeers(const char* peers);
+
+/*
+ * Connect this process to the others over TCP, peers is the list of the
+ * "host:port" of every process, in the order of the strips
+ */
+distrib_t* distribConnect(const char* peers, int rank, int wrap);
+
+/*
+ * Return the rank of this process, 0 for the first strip
+ */
+int distribRank(distrib_t* d);
+
+/*
+ * Return the number of processes
+ */
+int distribProcs(distrib_t* d);
+
+/*
+ * Close the links, the process 0 waits for the processes it forked
+ * Return the number of processes which failed
+ */
+int distribFree(distrib_t* d);
+
+/*
+ * Send its strip of the board to each process, down the chain of processes
+ * Only the process 0 gives the board and the generation, the others get them
+ * with the rule
+ */
+strip_t scatterStrips(distrib_t* d, packed_board_t board, long long generation);
+
+/*
+ * Advance the strips by n generations
+ * The halo rows are exchanged while the interior rows are computed
+ */
+void stepStrips(distrib_t* d, strip_t* strip, long long n);
+
+/*
+ * Return the number of living cells of the board to the process 0, the
+ * population of its own strip to the others
+ */
+long long stripsPopulation(distrib_t* d, strip_t strip);
+
+/*
+ * Write the whole board to a file from the process 0, the format is given by
+ * the extension, nothing is written if it is empty. Every process calls it,
+ * only the filename of the process 0 is used
+ */
+void gatherStrips(distrib_t* d, strip_t strip, const char* filename);
+
+/*
+ * Free memory of a strip
+ */
+void freeStrip(strip_t strip);
+
+#endif
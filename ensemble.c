@@ -0,0 +1,409 @@
+/*
+ * Title    : Game of life / ensemble
+ * Desc     : Ensembles of small independent boards, 64 boards per word stepped at once
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "ensemble.h"
+#include "automata.h"
+#include "boundary.h"
+#include "rule.h"
+#include "math.h"
+
+/*
+ * Return the word of the cell (0, 0) of a group
+ */
+static uint64_t* groupCells(const ensemble_t* ensemble, uint64_t* data, int g) {
+    return data + (size_t)g * ensemble->cells - boardIdx(-1, -1, ensemble->width);
+}
+
+/*
+ * Alocate an ensemble of boards of width x height dead cells
+ */
+ensemble_t allocEnsemble(int width, int height, int boards) {
+    ensemble_t ensemble;
+    ensemble.width = width;
+    ensemble.height = height;
+    ensemble.boards = boards;
+    ensemble.groups = (boards + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES;
+    ensemble.cells = (size_t)(width + 2) * (height + 2);
+
+    size_t words = (size_t)ensemble.groups * ensemble.cells;
+    ensemble.curr = calloc(words, sizeof(uint64_t));
+    ensemble.next = calloc(words, sizeof(uint64_t));
+    ensemble.saved = calloc(words, sizeof(uint64_t));
+    assert(ensemble.curr != NULL && ensemble.next != NULL && ensemble.saved != NULL);
+
+    ensemble.used = calloc(ensemble.groups, sizeof(uint64_t));
+    ensemble.periodic = calloc(ensemble.groups, sizeof(uint64_t));
+    ensemble.still = calloc(ensemble.groups, sizeof(uint64_t));
+    ensemble.extinct = calloc(ensemble.groups, sizeof(uint64_t));
+    assert(ensemble.used != NULL && ensemble.periodic != NULL && ensemble.still != NULL && ensemble.extinct != NULL);
+    ensemble.population = malloc(boards * sizeof(long long));
+    ensemble.period = malloc(boards * sizeof(long long));
+    ensemble.periodGen = malloc(boards * sizeof(long long));
+    ensemble.extinction = malloc(boards * sizeof(long long));
+    ensemble.savedGen = malloc(boards * sizeof(long long));
+    assert(ensemble.population != NULL && ensemble.period != NULL && ensemble.periodGen != NULL && ensemble.extinction != NULL);
+    assert(ensemble.savedGen != NULL);
+    clearEnsemble(&ensemble);
+
+    return ensemble;
+}
+
+/*
+ * Kill every cell of the boards and start again from the generation 0
+ */
+void clearEnsemble(ensemble_t* ensemble) {
+    size_t words = (size_t)ensemble->groups * ensemble->cells;
+    memset(ensemble->curr, 0, words * sizeof(uint64_t));
+    memset(ensemble->next, 0, words * sizeof(uint64_t));
+    memset(ensemble->saved, 0, words * sizeof(uint64_t));
+    ensemble->generation = 0;
+    ensemble->power = 1;
+    ensemble->lambda = 0;
+
+    for (int g = 0; g < ensemble->groups; g++) {
+        int lanes = ensemble->boards - g * ENSEMBLE_LANES;
+        ensemble->used[g] = (lanes >= ENSEMBLE_LANES ? ~0ULL : (1ULL << lanes) - 1);
+        ensemble->periodic[g] = 0;
+        ensemble->still[g] = 0;
+        // Dead boards, extinct from the start
+        ensemble->extinct[g] = ensemble->used[g];
+    }
+    for (int b = 0; b < ensemble->boards; b++) {
+        ensemble->population[b] = 0;
+        ensemble->period[b] = -1;
+        ensemble->periodGen[b] = -1;
+        ensemble->extinction[b] = 0;
+        ensemble->savedGen[b] = 0;
+    }
+}
+
+/*
+ * Set the board b of the ensemble, before the first generation
+ */
+void setEnsembleBoard(ensemble_t* ensemble, int b, board_t board) {
+    assert(board.width == ensemble->width && board.height == ensemble->height && ensemble->generation == 0);
+    int g = b / ENSEMBLE_LANES;
+    uint64_t lane = 1ULL << (b % ENSEMBLE_LANES);
+    uint64_t* cells = groupCells(ensemble, ensemble->curr, g);
+    uint64_t* saved = groupCells(ensemble, ensemble->saved, g);
+    long long population = 0;
+
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            long k = boardIdx(i, j, board.width);
+            cells[k] = (board.data[k] ? cells[k] | lane : cells[k] & ~lane);
+            saved[k] = cells[k];
+            population += (board.data[k] != 0);
+        }
+    }
+    ensemble->extinction[b] = (population == 0 ? 0 : -1);
+    ensemble->extinct[g] = (population == 0 ? ensemble->extinct[g] | lane : ensemble->extinct[g] & ~lane);
+}
+
+/*
+ * Write the board b of the ensemble to a board of the same dimensions
+ */
+void getEnsembleBoard(ensemble_t* ensemble, int b, board_t board) {
+    assert(board.width == ensemble->width && board.height == ensemble->height);
+    const uint64_t* cells = groupCells(ensemble, ensemble->curr, b / ENSEMBLE_LANES);
+    int shift = b % ENSEMBLE_LANES;
+
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            long k = boardIdx(i, j, board.width);
+            board.data[k] = (cells[k] >> shift) & 1;
+        }
+    }
+}
+
+/*
+ * Kill count cells (row and column pairs) of the board b of the ensemble
+ * The board is saved again, its period is searched from this generation
+ */
+void killEnsembleCells(ensemble_t* ensemble, int b, const int* cells, int count) {
+    uint64_t* data = groupCells(ensemble, ensemble->curr, b / ENSEMBLE_LANES);
+    uint64_t* saved = groupCells(ensemble, ensemble->saved, b / ENSEMBLE_LANES);
+    uint64_t lane = 1ULL << (b % ENSEMBLE_LANES);
+    for (int c = 0; c < count; c++) {
+        data[boardIdx(cells[2*c], cells[2*c+1], ensemble->width)] &= ~lane;
+    }
+    for (int i = 0; i < ensemble->height; i++) {
+        for (int j = 0; j < ensemble->width; j++) {
+            long k = boardIdx(i, j, ensemble->width);
+            saved[k] = (saved[k] & ~lane) | (data[k] & lane);
+        }
+    }
+    ensemble->savedGen[b] = ensemble->generation;
+}
+
+/*
+ * Return the lanes of the group g with living cells at most band cells from
+ * the border of the boards
+ */
+uint64_t ensembleBorderLanes(const ensemble_t* ensemble, int g, int band) {
+    const uint64_t* cells = groupCells(ensemble, ensemble->curr, g);
+    int width = ensemble->width;
+    int height = ensemble->height;
+    uint64_t lanes = 0;
+
+    for (int i = 0; i < height; i++) {
+        // The whole rows at the top and the bottom, both ends of the others
+        int full = (i < band || i >= height - band || 2*band >= width);
+        for (int j = 0; j < width; j += (full || j != band - 1 ? 1 : width - 2*band + 1)) {
+            lanes |= cells[boardIdx(i, j, width)];
+        }
+    }
+    return lanes;
+}
+
+/*
+ * Return the lanes of the group g whose cells at most band cells from the
+ * border changed since previous, a copy of them updated here. The changed
+ * cells are written to changes, a word per cell like the ensemble
+ */
+uint64_t ensembleBorderChanges(const ensemble_t* ensemble, int g, int band, uint64_t* previous, uint64_t* changes) {
+    const uint64_t* cells = groupCells(ensemble, ensemble->curr, g);
+    uint64_t* last = previous - boardIdx(-1, -1, ensemble->width);
+    uint64_t* diff = changes - boardIdx(-1, -1, ensemble->width);
+    int width = ensemble->width;
+    int height = ensemble->height;
+    uint64_t lanes = 0;
+
+    for (int i = 0; i < height; i++) {
+        // The whole rows at the top and the bottom, both ends of the others
+        int full = (i < band || i >= height - band || 2*band >= width);
+        for (int j = 0; j < width; j += (full || j != band - 1 ? 1 : width - 2*band + 1)) {
+            long k = boardIdx(i, j, width);
+            diff[k] = cells[k] ^ last[k];
+            lanes |= diff[k];
+            last[k] = cells[k];
+        }
+    }
+    return lanes;
+}
+
+/*
+ * Free memory of an ensemble
+ */
+void freeEnsemble(ensemble_t ensemble) {
+    free(ensemble.curr);
+    free(ensemble.next);
+    free(ensemble.saved);
+    free(ensemble.used);
+    free(ensemble.periodic);
+    free(ensemble.still);
+    free(ensemble.extinct);
+    free(ensemble.population);
+    free(ensemble.period);
+    free(ensemble.periodGen);
+    free(ensemble.extinction);
+    free(ensemble.savedGen);
+}
+
+/*
+ * Fill each board of the ensemble like randomBoard, the board b from seed + b
+ */
+void randomEnsemble(ensemble_t* ensemble, int rdmType, double density, uint64_t seed) {
+    board_t board = allocBoard(ensemble->width, ensemble->height);
+    for (int b = 0; b < ensemble->boards; b++) {
+        clearBoard(board);
+        randomBoard(board, rdmType, density, seed + b);
+        setEnsembleBoard(ensemble, b, board);
+    }
+    freeBoard(board);
+}
+
+/*
+ * Next generation of a group, return in alive the lanes with a living cell
+ * and in changed the lanes which differ from the saved boards
+ */
+static inline void stepGroup(const uint64_t* curr, uint64_t* next, const uint64_t* saved,
+                             int width, int height, unsigned birth, unsigned survival,
+                             uint64_t* alive, uint64_t* changed) {
+    uint64_t any = 0, diff = 0;
+    for (int i = 0; i < height; i++) {
+        const uint64_t* up = &curr[boardIdx(i-1, 0, width)];
+        const uint64_t* mid = &curr[boardIdx(i, 0, width)];
+        const uint64_t* down = &curr[boardIdx(i+1, 0, width)];
+        uint64_t* out = &next[boardIdx(i, 0, width)];
+        const uint64_t* old = &saved[boardIdx(i, 0, width)];
+
+        for (int j = 0; j < width; j++) {
+            uint64_t cell = lifeWordRule(up[j-1], up[j], up[j+1], mid[j-1], mid[j], mid[j+1],
+                                         down[j-1], down[j], down[j+1], birth, survival);
+            out[j] = cell;
+            any |= cell;
+            diff |= cell ^ old[j];
+        }
+    }
+    *alive = any;
+    *changed = diff;
+}
+
+#define ENSEMBLE_STEP(B, S) stepGroup(curr, next, saved, width, height, B, S, &alive, &changed)
+
+/*
+ * Advance every board by one generation and record the periods and extinctions
+ */
+static void stepOnce(ensemble_t* ensemble) {
+    int width = ensemble->width;
+    int height = ensemble->height;
+    rule_t rule = getRule();
+    ensemble->generation += 1;
+    ensemble->lambda += 1;
+
+    // A single group is stepped by the calling thread, e.g. a worker of the census
+    #pragma omp parallel for schedule(dynamic) if (ensemble->groups > 1)
+    for (int g = 0; g < ensemble->groups; g++) {
+        // Still lifes and dead boards stay the same, both buffers hold them
+        if (ensemble->still[g] == ensemble->used[g]) {
+            continue;
+        }
+        uint64_t* curr = groupCells(ensemble, ensemble->curr, g);
+        uint64_t* next = groupCells(ensemble, ensemble->next, g);
+        const uint64_t* saved = groupCells(ensemble, ensemble->saved, g);
+        uint64_t alive, changed;
+
+        fillLanesHalo(curr, width, height);
+        RULE_SPECIALIZE(rule, ENSEMBLE_STEP);
+
+        // Brent : the first generation equal to the saved one gives the period
+        uint64_t found = ~changed & ensemble->used[g] & ~ensemble->periodic[g];
+        uint64_t dead = ~alive & ensemble->used[g] & ~ensemble->extinct[g];
+        for (int b = 0; b < ENSEMBLE_LANES; b++) {
+            int board = g * ENSEMBLE_LANES + b;
+            if ((found >> b) & 1) {
+                ensemble->period[board] = ensemble->generation - ensemble->savedGen[board];
+                ensemble->periodGen[board] = ensemble->generation;
+                ensemble->still[g] |= (ensemble->period[board] == 1 ? 1ULL << b : 0);
+            }
+            if ((dead >> b) & 1) {
+                ensemble->extinction[board] = ensemble->generation;
+            }
+        }
+        ensemble->periodic[g] |= found;
+        ensemble->extinct[g] |= dead;
+    }
+
+    uint64_t* tmp = ensemble->curr;
+    ensemble->curr = ensemble->next;
+    ensemble->next = tmp;
+
+    if (ensemble->lambda == ensemble->power) {
+        memcpy(ensemble->saved, ensemble->curr, (size_t)ensemble->groups * ensemble->cells * sizeof(uint64_t));
+        ensemble->power *= 2;
+        ensemble->lambda = 0;
+        for (int b = 0; b < ensemble->boards; b++) {
+            ensemble->savedGen[b] = ensemble->generation;
+        }
+    }
+}
+
+/*
+ * Advance every board by n generations, the groups whose boards are all still
+ * lifes (or dead) are not computed anymore
+ */
+void stepEnsemble(ensemble_t* ensemble, long long n) {
+    for (long long k = 0; k < n; k++) {
+        stepOnce(ensemble);
+    }
+}
+
+/*
+ * Count the living cells of each board
+ */
+void ensemblePopulation(ensemble_t* ensemble) {
+    #pragma omp parallel for if (ensemble->groups > 1)
+    for (int g = 0; g < ensemble->groups; g++) {
+        const uint64_t* cells = groupCells(ensemble, ensemble->curr, g);
+        long long counts[ENSEMBLE_LANES] = { 0 };
+
+        for (int i = 0; i < ensemble->height; i++) {
+            for (int j = 0; j < ensemble->width; j++) {
+                uint64_t word = cells[boardIdx(i, j, ensemble->width)];
+                while (word != 0) {
+                    counts[__builtin_ctzll(word)] += 1;
+                    word &= word - 1;
+                }
+            }
+        }
+        for (int b = 0; b < ENSEMBLE_LANES && g * ENSEMBLE_LANES + b < ensemble->boards; b++) {
+            ensemble->population[g * ENSEMBLE_LANES + b] = counts[b];
+        }
+    }
+}
+
+/*
+ * Return 1 if the period of every board is known
+ */
+int ensembleSettled(ensemble_t* ensemble) {
+    for (int g = 0; g < ensemble->groups; g++) {
+        if (ensemble->periodic[g] != ensemble->used[g]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Write a value of the CSV, nothing if it is unknown (-1)
+ */
+static void writeField(FILE* file, long long value, const char* separator) {
+    if (value >= 0) {
+        fprintf(file, "%lld", value);
+    }
+    fprintf(file, "%s", separator);
+}
+
+/*
+ * Write the results of each board as CSV : final population, period and the
+ * generation it was found, generation of extinction (empty if unknown)
+ */
+void writeEnsembleCsv(ensemble_t ensemble, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "board,population,period,period_generation,extinction_generation\n");
+    for (int b = 0; b < ensemble.boards; b++) {
+        fprintf(file, "%d,%lld,", b, ensemble.population[b]);
+        writeField(file, ensemble.period[b], ",");
+        writeField(file, ensemble.periodGen[b], ",");
+        writeField(file, ensemble.extinction[b], "\n");
+    }
+    fclose(file);
+}
@@ -0,0 +1,149 @@
+/*
+ * Title    : Game of life / ensemble
+ * Desc     : Headers for the ensembles of small boards, one board per bit
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+
+#include <stdint.h>
+#include "board.h"
+
+/*
+ * Boards per group, one per bit of a word
+ */
+#define ENSEMBLE_LANES 64
+
+/*
+ * Boards of width x height cells stepped together. A group holds 64 boards in
+ * one word per cell (with a halo), the bit b of each word being the board b of
+ * the group, so the bit-sliced kernel of the packed engine computes a cell of
+ * the 64 boards at once
+ * The period of each board is found with Brent's algorithm : the boards are
+ * saved at the generations 2^k and compared with each next generation
+ */
+typedef struct ensemble {
+    uint64_t* curr;
+    uint64_t* next;
+    uint64_t* saved;
+    int width;
+    int height;
+    int boards;
+    int groups;
+    size_t cells;
+    long long generation;
+    long long power;
+    long long lambda;
+
+    // Lanes of each group : used, periodic, still (period 1) and extinct
+    uint64_t* used;
+    uint64_t* periodic;
+    uint64_t* still;
+    uint64_t* extinct;
+
+    // Results of each board, -1 until known
+    long long* population;
+    long long* period;
+    long long* periodGen;
+    long long* extinction;
+    // Generation of the saved board of each board
+    long long* savedGen;
+} ensemble_t;
+
+/*
+ * Alocate an ensemble of boards of width x height dead cells
+ */
+ensemble_t allocEnsemble(int width, int height, int boards);
+
+/*
+ * Free memory of an ensemble
+ */
+void freeEnsemble(ensemble_t ensemble);
+
+/*
+ * Kill every cell of the boards and start again from the generation 0
+ */
+void clearEnsemble(ensemble_t* ensemble);
+
+/*
+ * Set the board b of the ensemble, before the first generation
+ */
+void setEnsembleBoard(ensemble_t* ensemble, int b, board_t board);
+
+/*
+ * Write the board b of the ensemble to a board of the same dimensions
+ */
+void getEnsembleBoard(ensemble_t* ensemble, int b, board_t board);
+
+/*
+ * Kill count cells (row and column pairs) of the board b of the ensemble
+ * The board is saved again, its period is searched from this generation
+ */
+void killEnsembleCells(ensemble_t* ensemble, int b, const int* cells, int count);
+
+/*
+ * Return the lanes of the group g with living cells at most band cells from
+ * the border of the boards
+ */
+uint64_t ensembleBorderLanes(const ensemble_t* ensemble, int g, int band);
+
+/*
+ * Return the lanes of the group g whose cells at most band cells from the
+ * border changed since previous, a copy of them updated here. The changed
+ * cells are written to changes, a word per cell like the ensemble
+ */
+uint64_t ensembleBorderChanges(const ensemble_t* ensemble, int g, int band, uint64_t* previous, uint64_t* changes);
+
+/*
+ * Fill each board of the ensemble like randomBoard, the board b from seed + b
+ */
+void randomEnsemble(ensemble_t* ensemble, int rdmType, double density, uint64_t seed);
+
+/*
+ * Advance every board by n generations, the groups whose boards are all still
+ * lifes (or dead) are not computed anymore
+ */
+void stepEnsemble(ensemble_t* ensemble, long long n);
+
+/*
+ * Count the living cells of each board
+ */
+void ensemblePopulation(ensemble_t* ensemble);
+
+/*
+ * Return 1 if the period of every board is known
+ */
+int ensembleSettled(ensemble_t* ensemble);
+
+/*
+ * Write the results of each board as CSV : final population, period and the
+ * generation it was found, generation of extinction (empty if unknown)
+ */
+void writeEnsembleCsv(ensemble_t ensemble, const char* filename);
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * Title    : Game of life / export
+ * Desc     : Headless frame export, PGM images or a Y4M stream encoded by a background thread
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "viewport.h"
+#include "export.h"
+
+#define EXPORT_NAME 256
+#define EXPORT_FPS 30
+
+#define EXPORT_Y4M 0
+#define EXPORT_PGM 1
+
+/*
+ * Two frames : the caller fills one while the thread encodes the other
+ */
+struct exporter {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;
+    int quit;
+
+    int format;
+    FILE* stream;
+    char prefix[EXPORT_NAME];
+    int width;
+    int height;
+    unsigned char* fill;
+    unsigned char* frame;
+    unsigned char* line;
+    long long generation;
+
+    int count;
+    double writeTime;
+};
+
+/*
+ * Return the time in ms
+ */
+static double now(void) {
+    struct timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec*1e+3 + t.tv_usec*1e-3;
+}
+
+/*
+ * Write the frame in gray levels, one line at a time
+ */
+static void writeGray(exporter_t* exp, FILE* file) {
+    for (int y = 0; y < exp->height; y++) {
+        const unsigned char* values = &exp->frame[(size_t)y * exp->width];
+        for (int x = 0; x < exp->width; x++) {
+            exp->line[x] = viewGray(values[x]);
+        }
+        fwrite(exp->line, 1, exp->width, file);
+    }
+}
+
+/*
+ * Encode the frame, a Y4M frame is only the luma plane (Cmono)
+ */
+static void writeFrame(exporter_t* exp) {
+    if (exp->format == EXPORT_Y4M) {
+        fputs("FRAME\n", exp->stream);
+        writeGray(exp, exp->stream);
+        return;
+    }
+
+    char filename[EXPORT_NAME + 32];
+    snprintf(filename, sizeof(filename), "%s_%08lld.pgm", exp->prefix, exp->generation);
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        perror(filename);
+        return;
+    }
+    fprintf(file, "P5\n%d %d\n255\n", exp->width, exp->height);
+    writeGray(exp, file);
+    fclose(file);
+}
+
+/*
+ * Encoder thread, waits for a pending frame and writes it
+ */
+static void* encoderLoop(void* arg) {
+    exporter_t* exp = arg;
+
+    pthread_mutex_lock(&exp->lock);
+    while (1) {
+        while (!exp->pending && !exp->quit) {
+            pthread_cond_wait(&exp->cond, &exp->lock);
+        }
+        if (!exp->pending) {
+            break;
+        }
+        pthread_mutex_unlock(&exp->lock);
+
+        // The frame belongs to the encoder until pending is cleared
+        double begin = now();
+        writeFrame(exp);
+        double dur = now() - begin;
+
+        pthread_mutex_lock(&exp->lock);
+        exp->count += 1;
+        exp->writeTime += dur;
+        exp->pending = 0;
+        pthread_cond_broadcast(&exp->cond);
+    }
+    pthread_mutex_unlock(&exp->lock);
+
+    return NULL;
+}
+
+/*
+ * Open the target and start the encoder thread for frames of (width x height) pixels
+ * With the standard output as target, the texts printed go to stderr instead
+ */
+exporter_t* exportCreate(const char* target, int width, int height) {
+    exporter_t* exp = calloc(1, sizeof(exporter_t));
+    assert(exp != NULL);
+    exp->width = width;
+    exp->height = height;
+    exp->fill = malloc((size_t)width * height);
+    exp->frame = malloc((size_t)width * height);
+    exp->line = malloc(width);
+    assert(exp->fill != NULL && exp->frame != NULL && exp->line != NULL);
+
+    size_t length = strlen(target);
+    if (length > 4 && !strcmp(&target[length - 4], ".pgm")) {
+        exp->format = EXPORT_PGM;
+        snprintf(exp->prefix, EXPORT_NAME, "%.*s", (int)(length - 4), target);
+    } else if (!strcmp(target, "-")) {
+        // The stream keeps the real standard output, the texts are moved to stderr
+        exp->format = EXPORT_Y4M;
+        fflush(stdout);
+        exp->stream = fdopen(dup(STDOUT_FILENO), "wb");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    } else {
+        exp->format = EXPORT_Y4M;
+        exp->stream = fopen(target, "wb");
+    }
+
+    if (exp->format == EXPORT_Y4M) {
+        if (exp->stream == NULL) {
+            perror(target);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(exp->stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 Cmono\n", width, height, EXPORT_FPS);
+    }
+
+    pthread_mutex_init(&exp->lock, NULL);
+    pthread_cond_init(&exp->cond, NULL);
+    int err = pthread_create(&exp->thread, NULL, encoderLoop, exp);
+    assert(err == 0);
+
+    return exp;
+}
+
+/*
+ * Wait for the last frame to be written, close the target and stop the thread
+ */
+void exportFree(exporter_t* exp) {
+    pthread_mutex_lock(&exp->lock);
+    exp->quit = 1;
+    pthread_cond_broadcast(&exp->cond);
+    pthread_mutex_unlock(&exp->lock);
+    pthread_join(exp->thread, NULL);
+
+    if (exp->stream != NULL) {
+        fclose(exp->stream);
+    }
+    pthread_mutex_destroy(&exp->lock);
+    pthread_cond_destroy(&exp->cond);
+    free(exp->fill);
+    free(exp->frame);
+    free(exp->line);
+    free(exp);
+}
+
+/*
+ * Return the frame to fill with renderView, valid until the next exportFrame
+ */
+unsigned char* exportBuffer(exporter_t* exp) {
+    return exp->fill;
+}
+
+/*
+ * Hand the filled frame over to the encoder thread
+ * Return the stall in ms : waiting for the previous frame to be written
+ */
+double exportFrame(exporter_t* exp, long long generation) {
+    double begin = now();
+    pthread_mutex_lock(&exp->lock);
+    while (exp->pending) {
+        pthread_cond_wait(&exp->cond, &exp->lock);
+    }
+
+    unsigned char* tmp = exp->frame;
+    exp->frame = exp->fill;
+    exp->fill = tmp;
+    exp->generation = generation;
+    exp->pending = 1;
+    pthread_cond_broadcast(&exp->cond);
+    pthread_mutex_unlock(&exp->lock);
+
+    return now() - begin;
+}
+
+/*
+ * Wait until every frame is written
+ */
+void exportWait(exporter_t* exp) {
+    pthread_mutex_lock(&exp->lock);
+    while (exp->pending) {
+        pthread_cond_wait(&exp->cond, &exp->lock);
+    }
+    pthread_mutex_unlock(&exp->lock);
+}
+
+/*
+ * Number of frames written
+ */
+int exportCount(exporter_t* exp) {
+    pthread_mutex_lock(&exp->lock);
+    int count = exp->count;
+    pthread_mutex_unlock(&exp->lock);
+    return count;
+}
+
+/*
+ * Total time spent encoding and writing the frames in ms
+ */
+double exportWriteTime(exporter_t* exp) {
+    pthread_mutex_lock(&exp->lock);
+    double writeTime = exp->writeTime;
+    pthread_mutex_unlock(&exp->lock);
+    return writeTime;
+}
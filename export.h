@@ -0,0 +1,81 @@
+/*
+ * Title    : Game of life / export
+ * Desc     : Headers for the headless frame export
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _EXPORT_H_
+#define _EXPORT_H_
+
+/*
+ * Background encoder of frames, rendered views of the board
+ * The target gives the format :
+ *   "-"        YUV4MPEG2 (Y4M) stream on the standard output
+ *   name.y4m   Y4M file
+ *   name.pgm   one PGM image per frame, name_<generation>.pgm
+ * Each frame is filled by the caller then encoded and written by a thread
+ */
+typedef struct exporter exporter_t;
+
+/*
+ * Open the target and start the encoder thread for frames of (width x height) pixels
+ * With the standard output as target, the texts printed go to stderr instead
+ */
+exporter_t* exportCreate(const char* target, int width, int height);
+
+/*
+ * Wait for the last frame to be written, close the target and stop the thread
+ */
+void exportFree(exporter_t* exp);
+
+/*
+ * Return the frame to fill with renderView, valid until the next exportFrame
+ */
+unsigned char* exportBuffer(exporter_t* exp);
+
+/*
+ * Hand the filled frame over to the encoder thread
+ * Return the stall in ms : waiting for the previous frame to be written
+ */
+double exportFrame(exporter_t* exp, long long generation);
+
+/*
+ * Wait until every frame is written
+ */
+void exportWait(exporter_t* exp);
+
+/*
+ * Number of frames written
+ */
+int exportCount(exporter_t* exp);
+
+/*
+ * Total time spent encoding and writing the frames in ms
+ */
+double exportWriteTime(exporter_t* exp);
+
+#endif
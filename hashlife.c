@@ -0,0 +1,514 @@
+/*
+ * Title    : Game of life / hashlife
+ * Desc     : HashLife engine, memoized quadtree for very long runs
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "hashlife.h"
+#include "rule.h"
+#include "math.h"
+
+#define BLOCK_NODES 65536
+#define MIN_TABLE_SIZE 4096
+#define MIN_LEVEL 3
+#define MAX_LEVEL 62
+
+/*
+ * Canonical quadtree node, two nodes with the same children are the same node
+ * A node of level k covers 2^k x 2^k cells, level 0 nodes are single cells
+ * result is the centre of the node advanced by 2^resultStep generations
+ */
+struct node {
+    node_t* nw;
+    node_t* ne;
+    node_t* sw;
+    node_t* se;
+    node_t* result;
+    node_t* next;
+    uint64_t population;
+    int level;
+    int resultStep;
+    int mark;
+};
+
+struct hashlife {
+    node_t** table;
+    size_t tableSize;
+    size_t count;
+    size_t maxNodes;
+    node_t* freeNodes;
+    node_t** blocks;
+    size_t blockCount;
+    node_t leaves[2];
+    node_t* empty[MAX_LEVEL+1];
+    node_t* root;
+    node_t** stack;
+    size_t stackTop;
+    size_t stackSize;
+    size_t threshold;
+    int64_t originI;
+    int64_t originJ;
+};
+
+/*
+ * Hash of the four children of a node
+ */
+static inline size_t hashChildren(node_t* nw, node_t* ne, node_t* sw, node_t* se) {
+    uint64_t h = (uintptr_t)nw;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)ne;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)sw;
+    h = h * 0x9E3779B97F4A7C15ull + (uintptr_t)se;
+    return h ^ (h >> 31);
+}
+
+/*
+ * Take a node from the free list, allocating a new block when it's empty
+ */
+static node_t* newNode(hashlife_t* life) {
+    if (life->freeNodes == NULL) {
+        node_t* block = calloc(sizeof(node_t), BLOCK_NODES);
+        assert(block != NULL);
+        life->blocks = realloc(life->blocks, sizeof(node_t*) * (life->blockCount + 1));
+        assert(life->blocks != NULL);
+        life->blocks[life->blockCount++] = block;
+
+        for (int i = 0; i < BLOCK_NODES; i++) {
+            block[i].next = life->freeNodes;
+            life->freeNodes = &block[i];
+        }
+    }
+
+    node_t* n = life->freeNodes;
+    life->freeNodes = n->next;
+    return n;
+}
+
+/*
+ * Double the hash table size and rehash all the nodes
+ */
+static void growTable(hashlife_t* life) {
+    size_t newSize = life->tableSize * 2;
+    node_t** table = calloc(sizeof(node_t*), newSize);
+    assert(table != NULL);
+
+    for (size_t b = 0; b < life->tableSize; b++) {
+        node_t* n = life->table[b];
+        while (n != NULL) {
+            node_t* next = n->next;
+            size_t h = hashChildren(n->nw, n->ne, n->sw, n->se) & (newSize - 1);
+            n->next = table[h];
+            table[h] = n;
+            n = next;
+        }
+    }
+
+    free(life->table);
+    life->table = table;
+    life->tableSize = newSize;
+}
+
+/*
+ * Return the canonical node with the given children
+ */
+static node_t* join(hashlife_t* life, node_t* nw, node_t* ne, node_t* sw, node_t* se) {
+    size_t h = hashChildren(nw, ne, sw, se) & (life->tableSize - 1);
+    for (node_t* n = life->table[h]; n != NULL; n = n->next) {
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+            return n;
+        }
+    }
+
+    node_t* n = newNode(life);
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->result = NULL;
+    n->population = nw->population + ne->population + sw->population + se->population;
+    n->level = nw->level + 1;
+    n->resultStep = -1;
+    n->mark = 0;
+    n->next = life->table[h];
+    life->table[h] = n;
+
+    life->count += 1;
+    if (life->count > life->tableSize * 3 / 4) {
+        growTable(life);
+    }
+
+    return n;
+}
+
+/*
+ * Return the empty node of the given level
+ */
+static node_t* empty(hashlife_t* life, int level) {
+    if (life->empty[level] == NULL) {
+        node_t* e = empty(life, level - 1);
+        life->empty[level] = join(life, e, e, e, e);
+    }
+    return life->empty[level];
+}
+
+/*
+ * Return the node of level k-1 at the centre of a node
+ */
+static node_t* centre(hashlife_t* life, node_t* n) {
+    return join(life, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+/*
+ * Return a node of level k+1 with the node at its centre
+ */
+static node_t* expand(hashlife_t* life, node_t* n) {
+    node_t* e = empty(life, n->level - 1);
+    return join(life, join(life, e, e, e, n->nw), join(life, e, e, n->ne, e),
+                      join(life, e, n->sw, e, e), join(life, n->se, e, e, e));
+}
+
+/*
+ * Next generation of the 2x2 centre of a level 2 node, computed cell by cell
+ */
+static node_t* life4x4(hashlife_t* life, node_t* m) {
+    node_t* quads[4] = { m->nw, m->ne, m->sw, m->se };
+    int cells[4][4];
+    for (int q = 0; q < 4; q++) {
+        int i = (q / 2) * 2;
+        int j = (q % 2) * 2;
+        cells[i][j] = quads[q]->nw->population;
+        cells[i][j+1] = quads[q]->ne->population;
+        cells[i+1][j] = quads[q]->sw->population;
+        cells[i+1][j+1] = quads[q]->se->population;
+    }
+
+    node_t* out[4];
+    rule_t rule = getRule();
+    for (int c = 0; c < 4; c++) {
+        int i = 1 + c / 2;
+        int j = 1 + c % 2;
+        int sum = -cells[i][j];
+        for (int k = i-1; k <= i+1; k++) {
+            for (int l = j-1; l <= j+1; l++) {
+                sum += cells[k][l];
+            }
+        }
+        out[c] = &life->leaves[ruleNext(cells[i][j], sum, rule.birth, rule.survival)];
+    }
+
+    return join(life, out[0], out[1], out[2], out[3]);
+}
+
+/*
+ * Keep a node alive during a garbage collection
+ */
+static inline node_t* protect(hashlife_t* life, node_t* n) {
+    if (life->stackTop == life->stackSize) {
+        life->stackSize = (life->stackSize == 0 ? 256 : life->stackSize * 2);
+        life->stack = realloc(life->stack, sizeof(node_t*) * life->stackSize);
+        assert(life->stack != NULL);
+    }
+    life->stack[life->stackTop++] = n;
+    return n;
+}
+
+static void collect(hashlife_t* life);
+
+/*
+ * Return the centre of a node of level k advanced by 2^j generations, j <= k-2
+ * The node is split in 9 overlapping sub-nodes advanced recursively; when j is
+ * the maximal step they are advanced a second time, else only their centres are kept
+ * Every intermediate node is protected, so the cache can be collected at any call
+ */
+static node_t* successor(hashlife_t* life, node_t* m, int j) {
+    if (m->population == 0) {
+        return m->nw;
+    }
+    if (j > m->level - 2) {
+        j = m->level - 2;
+    }
+    if (m->result != NULL && m->resultStep == j) {
+        return m->result;
+    }
+
+    size_t top = life->stackTop;
+    protect(life, m);
+    if (life->count > life->threshold) {
+        collect(life);
+    }
+
+    node_t* s;
+    if (m->level == 2) {
+        s = life4x4(life, m);
+    } else {
+        node_t* a = m->nw;
+        node_t* b = m->ne;
+        node_t* c = m->sw;
+        node_t* d = m->se;
+
+        node_t* c1 = protect(life, successor(life, a, j));
+        node_t* c2 = protect(life, successor(life, join(life, a->ne, b->nw, a->se, b->sw), j));
+        node_t* c3 = protect(life, successor(life, b, j));
+        node_t* c4 = protect(life, successor(life, join(life, a->sw, a->se, c->nw, c->ne), j));
+        node_t* c5 = protect(life, successor(life, join(life, a->se, b->sw, c->ne, d->nw), j));
+        node_t* c6 = protect(life, successor(life, join(life, b->sw, b->se, d->nw, d->ne), j));
+        node_t* c7 = protect(life, successor(life, c, j));
+        node_t* c8 = protect(life, successor(life, join(life, c->ne, d->nw, c->se, d->sw), j));
+        node_t* c9 = protect(life, successor(life, d, j));
+
+        if (j < m->level - 2) {
+            s = join(life, join(life, c1->se, c2->sw, c4->ne, c5->nw),
+                           join(life, c2->se, c3->sw, c5->ne, c6->nw),
+                           join(life, c4->se, c5->sw, c7->ne, c8->nw),
+                           join(life, c5->se, c6->sw, c8->ne, c9->nw));
+        } else {
+            node_t* r1 = protect(life, successor(life, join(life, c1, c2, c4, c5), j));
+            node_t* r2 = protect(life, successor(life, join(life, c2, c3, c5, c6), j));
+            node_t* r3 = protect(life, successor(life, join(life, c4, c5, c7, c8), j));
+            node_t* r4 = successor(life, join(life, c5, c6, c8, c9), j);
+            s = join(life, r1, r2, r3, r4);
+        }
+    }
+
+    life->stackTop = top;
+    m->result = s;
+    m->resultStep = j;
+    return s;
+}
+
+/*
+ * Mark a node and its descendants as reachable
+ */
+static void markNode(node_t* n) {
+    while (n != NULL && !n->mark) {
+        n->mark = 1;
+        if (n->level == 0) {
+            return;
+        }
+        markNode(n->nw);
+        markNode(n->ne);
+        markNode(n->sw);
+        n = n->se;
+    }
+}
+
+/*
+ * Free every node that can't be reached from the root or the protected nodes
+ * Memoized results pointing to freed nodes are forgotten
+ * When most nodes are still alive the threshold is raised to avoid collecting again at once
+ */
+static void collect(hashlife_t* life) {
+    markNode(life->root);
+    for (size_t s = 0; s < life->stackTop; s++) {
+        markNode(life->stack[s]);
+    }
+    for (int l = 0; l <= MAX_LEVEL; l++) {
+        markNode(life->empty[l]);
+    }
+
+    for (size_t b = 0; b < life->tableSize; b++) {
+        node_t** link = &life->table[b];
+        while (*link != NULL) {
+            node_t* n = *link;
+            if (n->mark) {
+                link = &n->next;
+            } else {
+                *link = n->next;
+                n->next = life->freeNodes;
+                life->freeNodes = n;
+                life->count -= 1;
+            }
+        }
+    }
+
+    for (size_t b = 0; b < life->tableSize; b++) {
+        for (node_t* n = life->table[b]; n != NULL; n = n->next) {
+            if (n->result != NULL && !n->result->mark) {
+                n->result = NULL;
+                n->resultStep = -1;
+            }
+        }
+    }
+    for (size_t b = 0; b < life->tableSize; b++) {
+        for (node_t* n = life->table[b]; n != NULL; n = n->next) {
+            n->mark = 0;
+        }
+    }
+    life->leaves[0].mark = 0;
+    life->leaves[1].mark = 0;
+
+    life->threshold = life->maxNodes;
+    if (life->count > life->threshold / 2) {
+        life->threshold = life->count * 2;
+    }
+}
+
+/*
+ * Build the node of the given level whose top left cell is (i0, j0)
+ */
+static node_t* buildNode(hashlife_t* life, board_t board, int64_t i0, int64_t j0, int level) {
+    if (i0 >= board.height || j0 >= board.width) {
+        return empty(life, level);
+    }
+    if (level == 0) {
+        return &life->leaves[board.data[boardIdx(i0, j0, board.width)] != 0];
+    }
+
+    int64_t half = (int64_t)1 << (level - 1);
+    return join(life, buildNode(life, board, i0, j0, level - 1),
+                      buildNode(life, board, i0, j0 + half, level - 1),
+                      buildNode(life, board, i0 + half, j0, level - 1),
+                      buildNode(life, board, i0 + half, j0 + half, level - 1));
+}
+
+/*
+ * Write the living cells of a node whose top left cell is (i0, j0)
+ */
+static void storeNode(node_t* n, board_t board, int64_t i0, int64_t j0) {
+    int64_t side = (int64_t)1 << n->level;
+    if (n->population == 0 || i0 >= board.height || j0 >= board.width || i0 + side <= 0 || j0 + side <= 0) {
+        return;
+    }
+    if (n->level == 0) {
+        board.data[boardIdx(i0, j0, board.width)] = 1;
+        return;
+    }
+
+    int64_t half = side / 2;
+    storeNode(n->nw, board, i0, j0);
+    storeNode(n->ne, board, i0, j0 + half);
+    storeNode(n->sw, board, i0 + half, j0);
+    storeNode(n->se, board, i0 + half, j0 + half);
+}
+
+/**
+ * Create a HashLife universe containing the board
+ * The universe is unbounded, the board is only a window on it
+ */
+hashlife_t* hashlifeCreate(board_t board, size_t maxNodes) {
+    hashlife_t* life = calloc(sizeof(hashlife_t), 1);
+    assert(life != NULL);
+
+    life->tableSize = MIN_TABLE_SIZE;
+    life->table = calloc(sizeof(node_t*), life->tableSize);
+    assert(life->table != NULL);
+    life->maxNodes = maxNodes;
+    life->threshold = maxNodes;
+    life->leaves[1].population = 1;
+    life->empty[0] = &life->leaves[0];
+
+    hashlifeLoad(life, board);
+    return life;
+}
+
+/**
+ * Free the universe and all its nodes
+ */
+void hashlifeFree(hashlife_t* life) {
+    for (size_t b = 0; b < life->blockCount; b++) {
+        free(life->blocks[b]);
+    }
+    free(life->blocks);
+    free(life->stack);
+    free(life->table);
+    free(life);
+}
+
+/**
+ * Replace the universe content with the board
+ */
+void hashlifeLoad(hashlife_t* life, board_t board) {
+    int level = MIN_LEVEL;
+    while (((int64_t)1 << level) < max(board.width, board.height)) {
+        level += 1;
+    }
+
+    life->root = buildNode(life, board, 0, 0, level);
+    life->originI = 0;
+    life->originJ = 0;
+}
+
+/**
+ * Write the cells visible in the board window
+ */
+void hashlifeStore(hashlife_t* life, board_t board) {
+    clearBoard(board);
+    storeNode(life->root, board, life->originI, life->originJ);
+}
+
+/**
+ * Advance the universe by the given number of generations
+ * Each set bit of the number is one memoized jump of 2^k generations
+ */
+void hashlifeAdvance(hashlife_t* life, uint64_t generations) {
+    for (int j = 63; j >= 0; j--) {
+        if (!((generations >> j) & 1)) {
+            continue;
+        }
+
+        // The pattern must lie in the inner quarter, so it can't escape the centre in 2^j generations
+        node_t* root = life->root;
+        while (root->level < j + 3 || centre(life, centre(life, root))->population != root->population) {
+            assert(root->level < MAX_LEVEL);
+            int64_t shift = (int64_t)1 << (root->level - 1);
+            root = expand(life, root);
+            life->originI -= shift;
+            life->originJ -= shift;
+        }
+
+        int64_t shift = (int64_t)1 << (root->level - 2);
+        root = successor(life, root, j);
+        life->originI += shift;
+        life->originJ += shift;
+
+        // Drop the empty borders
+        while (root->level > MIN_LEVEL && centre(life, root)->population == root->population) {
+            shift = (int64_t)1 << (root->level - 2);
+            root = centre(life, root);
+            life->originI += shift;
+            life->originJ += shift;
+        }
+        life->root = root;
+    }
+}
+
+/**
+ * Return the number of living cells in the whole universe
+ */
+uint64_t hashlifePopulation(hashlife_t* life) {
+    return life->root->population;
+}
+
+/**
+ * Return the number of nodes currently allocated
+ */
+size_t hashlifeNodes(hashlife_t* life) {
+    return life->count;
+}
@@ -0,0 +1,77 @@
+/*
+ * Title    : Game of life / hashlife
+ * Desc     : Headers for the HashLife engine
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _HASHLIFE_H_
+#define _HASHLIFE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+
+/*
+ * Default bound of the node cache, garbage collected when exceeded
+ */
+#define HASHLIFE_MAX_NODES (1 << 21)
+
+typedef struct node node_t;
+typedef struct hashlife hashlife_t;
+
+/**
+ * Create a HashLife universe containing the board
+ * The universe is unbounded, the board is only a window on it
+ */
+hashlife_t* hashlifeCreate(board_t board, size_t maxNodes);
+/**
+ * Free the universe and all its nodes
+ */
+void hashlifeFree(hashlife_t* life);
+/**
+ * Replace the universe content with the board
+ */
+void hashlifeLoad(hashlife_t* life, board_t board);
+/**
+ * Write the cells visible in the board window
+ */
+void hashlifeStore(hashlife_t* life, board_t board);
+/**
+ * Advance the universe by the given number of generations
+ * Each set bit of the number is one memoized jump of 2^k generations
+ */
+void hashlifeAdvance(hashlife_t* life, uint64_t generations);
+/**
+ * Return the number of living cells in the whole universe
+ */
+uint64_t hashlifePopulation(hashlife_t* life);
+/**
+ * Return the number of nodes currently allocated
+ */
+size_t hashlifeNodes(hashlife_t* life);
+
+#endif
@@ -29,26 +29,143 @@ SOFTWARE.
 */
 
 #include <stdlib.h>
+#include <assert.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <float.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <SDL/SDL.h>
 #include "display.h"
 #include "board.h"
 #include "automata.h"
+#include "hashlife.h"
+#include "tiles.h"
+#include "sparse.h"
+#include "temporal.h"
+#include "pattern.h"
+#include "binary.h"
+#include "snapshot.h"
+#include "triplebuf.h"
+#include "viewport.h"
+#include "export.h"
+#include "bench.h"
+#include "counters.h"
+#include "rule.h"
+#include "boundary.h"
+#include "distrib.h"
+#include "cycle.h"
+#include "ensemble.h"
+#include "census.h"
+#include "math.h"
 
 #define MAIN_WAIT 5
 #define MIN_GEN_WAIT 16
+#define EXPORT_SIZE 512
+
+#define BENCH_WARMUP 5
+#define BENCH_MIN_GENERATIONS 20
+#define BENCH_MAX_GENERATIONS 200
+#define BENCH_TIME_MS 1000
+#define BENCH_MAX_RESULTS 1024
+#define MAX_COMMANDS 64
+
+#define CMD_TOGGLE 0
+#define CMD_STEP 1
+#define CMD_SAVE 2
+
+#define ENGINE_CHAR 0
+#define ENGINE_PACKED 1
+#define ENGINE_HASHLIFE 2
+#define ENGINE_TILES 3
+#define ENGINE_SPARSE 4
+#define ENGINE_TEMPORAL 5
+#define ENGINE_COUNT 6
+
+static const char* engineNames[ENGINE_COUNT] = { "char", "packed", "hashlife", "tiles", "sparse", "temporal" };
+
+// Configurations swept by the benchmark, hashlife is left out : random boards
+// are its worst case, it is meant for the long runs of regular patterns
+static const int benchSizes[] = { 256, 1024, 4096 };
+static const double benchDensities[] = { 0.1, 0.3, 0.5 };
+static const int benchEngines[] = { ENGINE_CHAR, ENGINE_PACKED, ENGINE_TILES, ENGINE_TEMPORAL, ENGINE_SPARSE };
 
 typedef struct game_state {
     board_t currBoard;
     board_t nextBoard;
-    int generation;
+    packed_board_t currPacked;
+    packed_board_t nextPacked;
+    hashlife_t* life;
+    tiles_t tiles;
+    sparse_t* universe;
+    changes_t changes;
+    int engine;
+    int blockGens;
+    long long generation;
 } game_state_t;
 
+/*
+ * Commands given by the display to the simulation thread
+ */
+typedef struct command {
+    int type;
+    int i;
+    int j;
+} command_t;
+
+/*
+ * State shared by the simulation thread and the display
+ * The generations go through the triple buffer, rendered with the view, the
+ * commands and the view through the locked queue, running and wait are read
+ * at each loop of the simulation
+ */
+typedef struct simulation {
+    game_state_t state;
+    triple_buffer_t* frames;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    command_t commands[MAX_COMMANDS];
+    int commandCount;
+    view_t view;
+    int viewChanged;
+    atomic_int running;
+    atomic_int wait;
+    atomic_int quit;
+} simulation_t;
+
+typedef struct options {
+    int width;
+    int height;
+    char* file;
+    int random;
+    int performance;
+    long long jump;
+    int engine;
+    int blockGens;
+    char* kernel;
+    int check;
+    char* output;
+    long long checkpoint;
+    char* exportTarget;
+    long long exportEvery;
+    int exportSize;
+    char* bench;
+    char* counters;
+    char* rule;
+    int boundary;
+    int procs;
+    char* peers;
+    int rank;
+    int cycles;
+    int ensemble;
+    long long census;
+    double density;
+    long long seed;
+} options_t;
+
 /**
  * Print an error and exit
  */
@@ -60,20 +177,102 @@ void errorExit(char* msg) {
 /**
  * Manage arguments
  */
-void manageArguments(int argc, char** argv, int* size, char** file, int* rand, int* performance) {
-    if (argc != 1 && argc != 3 && argc != 5 && argc != 7) {
+void manageArguments(int argc, char** argv, options_t* opts) {
+    if (argc % 2 == 0) {
         // Show help
-        printf("Usage : lifegame [-h] [-n <size>] [-f <file>] [-r <type>] [-p]\n");
+        printf("Usage : lifegame [-h] [-n <size|WxH>] [-f <file>] [-r <type>] [-d <density>] [--seed <n>] [-p <n>] [-j <n>] [-e <engine>] [-t <T>] [-k <kernel>] [-s <schedule>] [-c <n>] [-o <file>] [-R <rule>]\n");
+        printf("                [-b <boundary>]\n");
+        printf("                [--checkpoint-every <n>] [-x <file>] [--export-every <n>] [--export-size <pixels>]\n");
+        printf("                [--bench <file>] [--counters <mode>] [--cycles <n>] [--ensemble <n>] [--census <n>]\n");
+        printf("                [--procs <n>] [--peers <list> --rank <r>]\n");
         printf("         -h          Display this help page\n");
         printf("         -f <file>   Load a board from a file\n");
-        printf("                     The first line must be the board size\n");
-        printf("         -n <size>   Define the size of the board (the board is always a square)\n");
+        printf("                     Formats : plain text (.txt), the first line is the board size (or width height)\n");
+        printf("                               RLE (.rle) and Life 1.06 (.lif), centered on the board\n");
+        printf("                               binary (.lgb), memory mapped, keeps the generation\n");
+        printf("                     Without a known extension, the format is detected from the header\n");
+        printf("         -n <size|WxH>\n");
+        printf("                     Define the size of a square board, or the width and height (-n 1000x200)\n");
         printf("         -r <type>   Randomly generate the board\n");
         printf("                     Types : 1 - Full random\n");
         printf("                             2 - Random with a vertical symmetry\n");
         printf("                             3 - Random with a horizontal symmetry\n");
         printf("                             4 - Random with both symmetries\n");
+        printf("         -d <density>\n");
+        printf("                     Probability of a random cell to be alive (0 to 1, default %.2f)\n", RANDOM_DENSITY);
+        printf("         --seed <n>  Seed of the random boards, the same seed gives the same boards\n");
+        printf("                     whatever the host and the number of threads (default : the time,\n");
+        printf("                     %d for --census)\n", CENSUS_SEED);
         printf("         -p <n>      Run a performance test during n generations, without GUI\n");
+        printf("         -j <n>      Jump n generations at once, without GUI, and print the duration\n");
+        printf("         -e <engine> Board representation used for the simulation\n");
+        printf("                     Engines : char     - One byte per cell (default)\n");
+        printf("                               packed   - One bit per cell, 64 cells per operation\n");
+        printf("                               hashlife - Memoized quadtree on an unbounded plane,\n");
+        printf("                                          for very long runs of regular patterns\n");
+        printf("                               tiles    - Bit-packed 64x64 tiles, the tiles that didn't\n");
+        printf("                                          change are skipped\n");
+        printf("                               sparse   - Hashed 64x64 chunks on an unbounded plane,\n");
+        printf("                                          only the occupied chunks are stored\n");
+        printf("                               temporal - Bit-packed tiles advanced by T generations\n");
+        printf("                                          per memory pass\n");
+        printf("         -t <T>      Use the temporal engine with T generations per pass (1 to %d)\n", TEMPORAL_MAX_GENS);
+        printf("         -k <kernel> Kernel used by the char engine\n");
+        printf("                     Kernels : auto (default), seq, omp, sse2, avx2, avx512\n");
+        printf("                     auto picks the widest vector kernel supported by the CPU\n");
+        printf("                     all runs the performance test once per supported kernel\n");
+        printf("         -s <sched>  OpenMP schedule of the omp kernel : static, dynamic or guided,\n");
+        printf("                     optionally with a chunk size (dynamic,4)\n");
+        printf("         -c <n>      Check during n generations that the kernel gives the same boards\n");
+        printf("                     as the sequential one\n");
+        printf("         -o <file>   Save the final board of -p or -j (.txt, .rle, .lif or .lgb)\n");
+        printf("         -R <rule>   Life-like rule in the B/S notation (default B3/S23, or the rule\n");
+        printf("                     of the loaded file), e.g. B36/S23 (HighLife), B3678/S34678\n");
+        printf("                     (Day & Night), B2/S (Seeds). Rules with B0 are not supported\n");
+        printf("         -b <boundary>\n");
+        printf("                     What lies outside of the board, for the char, packed and tiles\n");
+        printf("                     engines : dead (default), torus (wraps around), mirror (edges\n");
+        printf("                     reflected) or klein (wraps, top and bottom flipped)\n");
+        printf("         --checkpoint-every <n>\n");
+        printf("                     Save the board every n generations of -p in the background,\n");
+        printf("                     to the -o file or checkpoint.lgb, and print the stall of each save\n");
+        printf("         -x <file>   Export the generations of -p as frames, encoded in the background\n");
+        printf("                     Targets : name.pgm - one PGM image per frame, name_<generation>.pgm\n");
+        printf("                               name.y4m - Y4M video (grayscale)\n");
+        printf("                               -        - Y4M video on the standard output, the texts\n");
+        printf("                                          are printed on stderr\n");
+        printf("         --export-every <n>\n");
+        printf("                     Export a frame every n generations (default 1)\n");
+        printf("         --export-size <pixels>\n");
+        printf("                     Largest side of the frames (default %d), boards bigger than it\n", EXPORT_SIZE);
+        printf("                     are zoomed out, each pixel gives the density of a square of cells\n");
+        printf("         --bench <file>\n");
+        printf("                     Sweep board sizes (or only -n), densities, engines, kernels and\n");
+        printf("                     thread counts, and write the latency per generation (median,\n");
+        printf("                     p95, p99) and the throughput to the file (.json or .csv)\n");
+        printf("         --counters <mode>\n");
+        printf("                     Read the hardware counters during -p (cycles, instructions, L1d\n");
+        printf("                     and LLC misses, branch misses), total : print the totals and the\n");
+        printf("                     values per cell, gen : also print them after each generation\n");
+        printf("         --cycles <n>\n");
+        printf("                     Stop -p once the board is periodic, with a period of up to about\n");
+        printf("                     n generations (1 to %d), for the char, packed, tiles and\n", CYCLE_MAX_HISTORY);
+        printf("                     temporal engines (one generation per pass), and print the period\n");
+        printf("         --ensemble <n>\n");
+        printf("                     Run -p generations of n independent random boards of -n cells\n");
+        printf("                     (-r, full random by default), 64 boards per word, and write the\n");
+        printf("                     population, period and extinction of each one to the -o file (.csv)\n");
+        printf("         --census <n>\n");
+        printf("                     Run n seeded random soups of -n cells (default %d) until they are\n", CENSUS_SOUP);
+        printf("                     periodic (at most -p generations, default %d), split them in\n", CENSUS_MAX_GENERATIONS);
+        printf("                     objects and count the objects by canonical form, on every core.\n");
+        printf("                     The report of every object is written to the -o file (.csv)\n");
+        printf("         --procs <n> Split the board of -j in n strips of rows (1 to %d), each one\n", DISTRIB_MAX_PROCS);
+        printf("                     computed by a process of this host with the packed engine\n");
+        printf("         --peers <list>\n");
+        printf("                     Same as --procs over TCP, one process started per host:port of the\n");
+        printf("                     list (host1:5000,host2:5000,...), the first one loads the board\n");
+        printf("         --rank <r>  Index in the list of peers of this process (default 0)\n");
         exit(EXIT_SUCCESS);
     }
 
@@ -81,8 +280,12 @@ void manageArguments(int argc, char** argv, int* size, char** file, int* rand, i
         // size
         if (!strcmp(argv[i], "-n")) {
             if (i+1 < argc) {
-                *size = atoi(argv[i+1]);
-                if (*size <= 0) {
+                // A single size gives a square board, WxH a rectangular one
+                int n = sscanf(argv[i+1], "%dx%d", &opts->width, &opts->height);
+                if (n == 1) {
+                    opts->height = opts->width;
+                }
+                if (n < 1 || opts->width <= 0 || opts->height <= 0) {
                     errorExit("Invalid arguments");
                 }
             } else {
@@ -92,7 +295,7 @@ void manageArguments(int argc, char** argv, int* size, char** file, int* rand, i
         // file
         else if (!strcmp(argv[i], "-f")) {
             if (i+1 < argc) {
-                *file = argv[i+1];
+                opts->file = argv[i+1];
             } else {
                 errorExit("Invalid arguments");
             }
@@ -100,7 +303,7 @@ void manageArguments(int argc, char** argv, int* size, char** file, int* rand, i
         // random
         else if (!strcmp(argv[i], "-r")) {
             if (i+1 < argc) {
-                *rand = atoi(argv[i+1]);
+                opts->random = atoi(argv[i+1]);
             } else {
                 errorExit("Invalid arguments");
             }
@@ -108,186 +311,1465 @@ void manageArguments(int argc, char** argv, int* size, char** file, int* rand, i
         // performance
         else if (!strcmp(argv[i], "-p")) {
             if (i+1 < argc) {
-                *performance = atoi(argv[i+1]);
-                if (*performance <= 0) {
+                opts->performance = atoi(argv[i+1]);
+                if (opts->performance <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // jump
+        else if (!strcmp(argv[i], "-j")) {
+            if (i+1 < argc) {
+                opts->jump = atoll(argv[i+1]);
+                if (opts->jump <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // engine
+        else if (!strcmp(argv[i], "-e")) {
+            opts->engine = -1;
+            for (int e = 0; e < ENGINE_COUNT && i+1 < argc; e++) {
+                if (!strcmp(argv[i+1], engineNames[e])) {
+                    opts->engine = e;
+                }
+            }
+            if (opts->engine < 0) {
+                errorExit("Invalid arguments");
+            }
+        }
+        // temporal blocking
+        else if (!strcmp(argv[i], "-t")) {
+            if (i+1 < argc) {
+                opts->engine = ENGINE_TEMPORAL;
+                opts->blockGens = atoi(argv[i+1]);
+                if (opts->blockGens < 1 || opts->blockGens > TEMPORAL_MAX_GENS) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // schedule
+        else if (!strcmp(argv[i], "-s")) {
+            if (i+1 >= argc || !setSchedule(argv[i+1])) {
+                errorExit("Invalid arguments");
+            }
+        }
+        // check
+        else if (!strcmp(argv[i], "-c")) {
+            if (i+1 < argc) {
+                opts->check = atoi(argv[i+1]);
+                if (opts->check <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // output
+        else if (!strcmp(argv[i], "-o")) {
+            if (i+1 < argc) {
+                opts->output = argv[i+1];
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // checkpoints
+        else if (!strcmp(argv[i], "--checkpoint-every")) {
+            if (i+1 < argc) {
+                opts->checkpoint = atoll(argv[i+1]);
+                if (opts->checkpoint <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // export
+        else if (!strcmp(argv[i], "-x")) {
+            if (i+1 < argc) {
+                opts->exportTarget = argv[i+1];
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        else if (!strcmp(argv[i], "--export-every")) {
+            if (i+1 < argc) {
+                opts->exportEvery = atoll(argv[i+1]);
+                if (opts->exportEvery <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        else if (!strcmp(argv[i], "--export-size")) {
+            if (i+1 < argc) {
+                opts->exportSize = atoi(argv[i+1]);
+                if (opts->exportSize <= 0) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // benchmark
+        else if (!strcmp(argv[i], "--bench")) {
+            if (i+1 < argc) {
+                opts->bench = argv[i+1];
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // performance counters
+        else if (!strcmp(argv[i], "--counters")) {
+            if (i+1 < argc && (!strcmp(argv[i+1], "total") || !strcmp(argv[i+1], "gen"))) {
+                opts->counters = argv[i+1];
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // cycle detection
+        else if (!strcmp(argv[i], "--cycles")) {
+            if (i+1 < argc) {
+                opts->cycles = atoi(argv[i+1]);
+                if (opts->cycles < 1 || opts->cycles > CYCLE_MAX_HISTORY) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // ensemble
+        else if (!strcmp(argv[i], "--ensemble")) {
+            if (i+1 < argc) {
+                opts->ensemble = atoi(argv[i+1]);
+                if (opts->ensemble < 1) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // density
+        else if (!strcmp(argv[i], "-d")) {
+            char* end;
+            if (i+1 < argc) {
+                opts->density = strtod(argv[i+1], &end);
+                if (*end != '\0' || end == argv[i+1] || !(opts->density >= 0 && opts->density <= 1)) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // seed
+        else if (!strcmp(argv[i], "--seed")) {
+            if (i+1 < argc) {
+                opts->seed = atoll(argv[i+1]);
+                if (opts->seed < 0) {
                     errorExit("Invalid arguments");
                 }
             } else {
                 errorExit("Invalid arguments");
             }
         }
+        // census
+        else if (!strcmp(argv[i], "--census")) {
+            if (i+1 < argc) {
+                opts->census = atoll(argv[i+1]);
+                if (opts->census < 1) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // processes
+        else if (!strcmp(argv[i], "--procs")) {
+            if (i+1 < argc) {
+                opts->procs = atoi(argv[i+1]);
+                if (opts->procs < 1 || opts->procs > DISTRIB_MAX_PROCS) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        else if (!strcmp(argv[i], "--peers")) {
+            if (i+1 < argc) {
+                opts->peers = argv[i+1];
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        else if (!strcmp(argv[i], "--rank")) {
+            if (i+1 < argc) {
+                opts->rank = atoi(argv[i+1]);
+                if (opts->rank < 0 || opts->rank >= DISTRIB_MAX_PROCS) {
+                    errorExit("Invalid arguments");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // boundary
+        else if (!strcmp(argv[i], "-b")) {
+            if (i+1 < argc && parseBoundary(argv[i+1]) >= 0) {
+                opts->boundary = parseBoundary(argv[i+1]);
+                setBoundary(opts->boundary);
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+        // rule
+        else if (!strcmp(argv[i], "-R")) {
+            rule_t rule;
+            if (i+1 < argc && parseRule(argv[i+1], &rule)) {
+                opts->rule = argv[i+1];
+                setRule(rule);
+            } else {
+                errorExit("Invalid or unsupported rule");
+            }
+        }
+        // kernel
+        else if (!strcmp(argv[i], "-k")) {
+            if (i+1 < argc) {
+                opts->kernel = argv[i+1];
+                if (strcmp(opts->kernel, "all") && !selectKernel(opts->kernel)) {
+                    errorExit("Unknown or unsupported kernel");
+                }
+            } else {
+                errorExit("Invalid arguments");
+            }
+        }
+    }
+}
+
+/*
+ * Create the game state from an initial board, the state owns the board
+ * The bit-packed engines can start from a packed board instead (data of board
+ * NULL), currBoard is then allocated at the first syncBoard
+ */
+game_state_t createState(board_t board, packed_board_t packed, int engine, int blockGens) {
+    game_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.currBoard = board;
+    if (engine == ENGINE_CHAR) {
+        state.nextBoard = allocBoard(board.width, board.height);
+    }
+    state.engine = engine;
+    state.blockGens = blockGens;
+
+    if (engine == ENGINE_PACKED || engine == ENGINE_TEMPORAL) {
+        if (packed.data != NULL) {
+            state.currPacked = packed;
+        } else {
+            state.currPacked = allocPackedBoard(board.width, board.height);
+            packBoard(state.currBoard, state.currPacked);
+        }
+        state.nextPacked = allocPackedBoard(board.width, board.height);
+    } else if (engine == ENGINE_HASHLIFE) {
+        state.life = hashlifeCreate(state.currBoard, HASHLIFE_MAX_NODES);
+    } else if (engine == ENGINE_TILES) {
+        state.tiles = allocTiles(board.width, board.height);
+        packTiles(&state.tiles, state.currBoard);
+    } else if (engine == ENGINE_SPARSE) {
+        state.universe = sparseCreate(state.currBoard);
+    }
+
+    return state;
+}
+
+/*
+ * Free memory of the game state
+ */
+void freeState(game_state_t state) {
+    freeBoard(state.currBoard);
+    freeBoard(state.nextBoard);
+    if (state.engine == ENGINE_PACKED || state.engine == ENGINE_TEMPORAL) {
+        freePackedBoard(state.currPacked);
+        freePackedBoard(state.nextPacked);
+    } else if (state.engine == ENGINE_HASHLIFE) {
+        hashlifeFree(state.life);
+    } else if (state.engine == ENGINE_TILES) {
+        freeTiles(state.tiles);
+    } else if (state.engine == ENGINE_SPARSE) {
+        sparseFree(state.universe);
+    }
+    freeChanges(state.changes);
+}
+
+/*
+ * Make the char and packed engines keep the tiles changed by each generation,
+ * for the consumers of stateTileChanged
+ */
+void trackChanges(game_state_t* state) {
+    if ((state->engine == ENGINE_CHAR || state->engine == ENGINE_PACKED) && state->changes.rows == NULL) {
+        state->changes = allocChanges(state->currBoard.width, state->currBoard.height);
     }
 }
 
 /*
  * Calculate next board state
+ * The temporal engine advances blockGens generations at once
  */
 void updateState(game_state_t* state) {
-    calculateState(state->currBoard, state->nextBoard);
-    
-    board_t tmp = state->currBoard;
-    state->currBoard = state->nextBoard;
-    state->nextBoard = tmp;
+    changes_t* tracked = (state->changes.rows != NULL ? &state->changes : NULL);
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        if (state->engine == ENGINE_TEMPORAL) {
+            calculateStateTemporal(state->currPacked, state->nextPacked, state->blockGens);
+            state->generation += state->blockGens - 1;
+        } else {
+            calculateStatePacked(state->currPacked, state->nextPacked, tracked);
+        }
+
+        packed_board_t tmp = state->currPacked;
+        state->currPacked = state->nextPacked;
+        state->nextPacked = tmp;
+    } else if (state->engine == ENGINE_HASHLIFE) {
+        hashlifeAdvance(state->life, 1);
+    } else if (state->engine == ENGINE_TILES) {
+        calculateStateTiles(&state->tiles);
+    } else if (state->engine == ENGINE_SPARSE) {
+        calculateStateSparse(state->universe);
+    } else {
+        calculateState(state->currBoard, state->nextBoard, tracked);
+
+        board_t tmp = state->currBoard;
+        state->currBoard = state->nextBoard;
+        state->nextBoard = tmp;
+    }
+    if (tracked != NULL) {
+        summarizeChanges(tracked);
+    }
     state->generation += 1;
 }
 
-void guiLoop(game_state_t state) {
+/*
+ * Bring currBoard up to date with the engine representation
+ */
+void syncBoard(game_state_t* state) {
+    if (state->currBoard.data == NULL) {
+        state->currBoard = allocBoard(state->currBoard.width, state->currBoard.height);
+    }
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        unpackBoard(state->currPacked, state->currBoard);
+    } else if (state->engine == ENGINE_HASHLIFE) {
+        hashlifeStore(state->life, state->currBoard);
+    } else if (state->engine == ENGINE_TILES) {
+        unpackTiles(state->tiles, state->currBoard);
+    } else if (state->engine == ENGINE_SPARSE) {
+        sparseStore(state->universe, state->currBoard);
+    }
+}
+
+/*
+ * Reload the engine representation after currBoard was edited
+ * HashLife and sparse keep only the cells inside the board window
+ */
+void reloadBoard(game_state_t* state) {
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        packBoard(state->currBoard, state->currPacked);
+    } else if (state->engine == ENGINE_HASHLIFE) {
+        hashlifeLoad(state->life, state->currBoard);
+    } else if (state->engine == ENGINE_TILES) {
+        packTiles(&state->tiles, state->currBoard);
+    } else if (state->engine == ENGINE_SPARSE) {
+        sparseLoad(state->universe, state->currBoard);
+    }
+}
+
+/*
+ * Advance the game by n generations
+ * HashLife jumps directly, the other engines step one generation at a time
+ */
+void jumpState(game_state_t* state, long long n) {
+    if (state->engine == ENGINE_HASHLIFE) {
+        hashlifeAdvance(state->life, n);
+        state->generation += n;
+    } else if (state->engine == ENGINE_TEMPORAL) {
+        int blockGens = state->blockGens;
+        while (n > 0) {
+            state->blockGens = (n < blockGens ? n : blockGens);
+            n -= state->blockGens;
+            updateState(state);
+        }
+        state->blockGens = blockGens;
+    } else {
+        for (long long g = 0; g < n; g++) {
+            updateState(state);
+        }
+    }
+}
+
+/*
+ * Return the number of living cells
+ */
+long long statePopulation(game_state_t* state) {
+    if (state->engine == ENGINE_HASHLIFE) {
+        return hashlifePopulation(state->life);
+    } else if (state->engine == ENGINE_SPARSE) {
+        return sparsePopulation(state->universe);
+    } else if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        return packedPopulation(state->currPacked);
+    }
+
+    syncBoard(state);
+    return boardPopulation(state->currBoard);
+}
+
+/*
+ * Save the current board of the game, the format is given by the extension
+ */
+void saveState(game_state_t* state, const char* filename) {
+    if (patternFormat(filename, NULL, 0) == FORMAT_BINARY) {
+        // Binary boards keep the generation, the packed engines are written as is
+        if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+            writeBinaryBoard(state->currPacked, state->generation, filename);
+        } else {
+            syncBoard(state);
+            packed_board_t packed = allocPackedBoard(state->currBoard.width, state->currBoard.height);
+            packBoard(state->currBoard, packed);
+            writeBinaryBoard(packed, state->generation, filename);
+            freePackedBoard(packed);
+        }
+    } else {
+        syncBoard(state);
+        saveBoardAs(state->currBoard, filename);
+    }
+    printf("Board saved to %s\n", filename);
+}
+
+/*
+ * Save the current board of the game in the background, return the stall in ms
+ * The packed engines are copied as is, the other ones are synced first
+ */
+double snapshotState(snapshot_t* snap, game_state_t* state, const char* filename) {
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        return snapshotPacked(snap, state->currPacked, state->generation, filename);
+    }
+
+    struct timeval begin, end;
+    gettimeofday(&begin, 0);
+    syncBoard(state);
+    gettimeofday(&end, 0);
+
+    double sync = (end.tv_sec - begin.tv_sec)*1e+3 + (end.tv_usec - begin.tv_usec)*1e-3;
+    return sync + snapshotBoard(snap, state->currBoard, state->generation, filename);
+}
+
+/*
+ * Write the current board in a bit-packed frame
+ */
+void packState(game_state_t* state, packed_board_t frame) {
+    size_t length = (size_t)(frame.height + 2) * frame.words * sizeof(uint64_t);
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        memcpy(frame.data, state->currPacked.data, length);
+    } else if (state->engine == ENGINE_TILES) {
+        memcpy(frame.data, state->tiles.curr.data, length);
+    } else {
+        syncBoard(state);
+        packBoard(state->currBoard, frame);
+    }
+}
+
+/*
+ * Return 1 if the engine knows the tiles of 64 x 64 cells changed by the last
+ * generation : the tiles engine, and the char and packed ones after trackChanges
+ */
+int stateTracksTiles(game_state_t* state) {
+    return state->engine == ENGINE_TILES || state->changes.rows != NULL;
+}
+
+/*
+ * Return 1 if the tile (ti, tj) of 64 x 64 cells changed in the last generation
+ */
+int stateTileChanged(game_state_t* state, int ti, int tj) {
+    if (state->engine == ENGINE_TILES) {
+        return tileChanged(state->tiles, ti, tj);
+    }
+    return state->changes.tiles[(size_t)ti * state->changes.tileCols + tj];
+}
+
+/*
+ * Mark the tiles of the density map changed by the last generation
+ * Every tile is counted again for the engines which don't track them
+ */
+void markDensity(game_state_t* state, density_t* density) {
+    if (!stateTracksTiles(state)) {
+        densityDirtyAll(density);
+        return;
+    }
+    for (int ti = 0; ti < density->rows; ti++) {
+        for (int tj = 0; tj < density->cols; tj++) {
+            if (stateTileChanged(state, ti, tj)) {
+                densityDirtyTile(density, ti, tj);
+            }
+        }
+    }
+}
+
+/*
+ * Mark the tiles of the cycle detection changed by the last generation
+ * Every tile is hashed again for the engines which don't track them
+ */
+void markCycle(game_state_t* state, cycle_t* cycle) {
+    if (!stateTracksTiles(state)) {
+        cycleDirtyAll(cycle);
+        return;
+    }
+    for (int ti = 0; ti < cycle->rows; ti++) {
+        for (int tj = 0; tj < cycle->cols; tj++) {
+            if (stateTileChanged(state, ti, tj)) {
+                cycleDirtyTile(cycle, ti, tj);
+            }
+        }
+    }
+}
+
+/*
+ * Set the flags of the lines of the view changed by the last generation
+ * Every line is drawn again for the engines which don't track their tiles
+ */
+void markLines(game_state_t* state, view_t view, unsigned char* lines) {
+    if (!stateTracksTiles(state)) {
+        memset(lines, 1, view.height);
+        return;
+    }
+    int rows = (state->currBoard.height + VIEW_TILE - 1) / VIEW_TILE;
+    int cols = (state->currBoard.width + VIEW_TILE - 1) / VIEW_TILE;
+    for (int ti = 0; ti < rows; ti++) {
+        for (int tj = 0; tj < cols; tj++) {
+            if (stateTileChanged(state, ti, tj)) {
+                viewDirtyTile(view, ti, tj, lines);
+            }
+        }
+    }
+}
+
+/*
+ * Return the current board bit-packed, written in scratch by the engines
+ * which don't keep one
+ */
+packed_board_t viewSource(game_state_t* state, packed_board_t scratch) {
+    if (state->engine == ENGINE_PACKED || state->engine == ENGINE_TEMPORAL) {
+        return state->currPacked;
+    } else if (state->engine == ENGINE_TILES) {
+        return state->tiles.curr;
+    }
+    packState(state, scratch);
+    return scratch;
+}
+
+/*
+ * Give a command to the simulation thread, dropped if the queue is full
+ */
+void pushCommand(simulation_t* sim, int type, int i, int j) {
+    pthread_mutex_lock(&sim->lock);
+    if (sim->commandCount < MAX_COMMANDS) {
+        command_t cmd = { type, i, j };
+        sim->commands[sim->commandCount++] = cmd;
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+/*
+ * Give the view to render to the simulation thread
+ */
+void setView(simulation_t* sim, view_t view) {
+    pthread_mutex_lock(&sim->lock);
+    sim->view = view;
+    sim->viewChanged = 1;
+    pthread_mutex_unlock(&sim->lock);
+}
+
+/*
+ * Run the commands given by the display and take the new view, the lines of
+ * the view they change are flagged in lines
+ * Return 1 if the board or the view changed
+ */
+int runCommands(simulation_t* sim, snapshot_t* snap, view_t* view, density_t* density, unsigned char* lines) {
+    command_t commands[MAX_COMMANDS];
+    pthread_mutex_lock(&sim->lock);
+    int count = sim->commandCount;
+    memcpy(commands, sim->commands, count * sizeof(command_t));
+    sim->commandCount = 0;
+    int changed = sim->viewChanged;
+    *view = sim->view;
+    sim->viewChanged = 0;
+    pthread_mutex_unlock(&sim->lock);
+    if (changed) {
+        memset(lines, 1, view->height);
+    }
+
+    game_state_t* state = &sim->state;
+    for (int k = 0; k < count; k++) {
+        if (commands[k].type == CMD_TOGGLE) {
+            syncBoard(state);
+            long cell = boardIdx(commands[k].i, commands[k].j, state->currBoard.width);
+            state->currBoard.data[cell] = !state->currBoard.data[cell];
+            reloadBoard(state);
+            densityDirtyTile(density, commands[k].i / VIEW_TILE, commands[k].j / VIEW_TILE);
+            viewDirtyTile(*view, commands[k].i / VIEW_TILE, commands[k].j / VIEW_TILE, lines);
+            changed = 1;
+        } else if (commands[k].type == CMD_STEP) {
+            updateState(state);
+            markDensity(state, density);
+            markLines(state, *view, lines);
+            changed = 1;
+        } else if (commands[k].type == CMD_SAVE) {
+            // The board is written in the background
+            char filename[29];
+            saveFileName(filename, sizeof(filename));
+            snapshotState(snap, state, filename);
+        }
+    }
+    return changed;
+}
+
+/*
+ * Simulation thread, runs the generations and publishes them to the display
+ * Each frame is the view rendered, its cost depends on the screen, not the board
+ * At unlimited speed, a frame is published every MAIN_WAIT ms at most
+ */
+void* simulationLoop(void* arg) {
+    simulation_t* sim = arg;
+    snapshot_t* snap = snapshotCreate();
+    Uint32 lastStep = SDL_GetTicks();
+    Uint32 lastPublish = 0;
+    int stale = 1;
+
+    int width = sim->state.currBoard.width;
+    int height = sim->state.currBoard.height;
+    view_t view = sim->view;
+    density_t density = allocDensity(width, height);
+    trackChanges(&sim->state);
+    // Lines changed since the last published frame, all of them for the first one
+    unsigned char* lines = malloc(view.height);
+    assert(lines != NULL);
+    memset(lines, 1, view.height);
+    long long sequence = 0;
+    packed_board_t scratch = { NULL, width, height, 0, NULL, 0 };
+    if (sim->state.engine != ENGINE_PACKED && sim->state.engine != ENGINE_TEMPORAL
+        && sim->state.engine != ENGINE_TILES) {
+        scratch = allocPackedBoard(width, height);
+    }
+
+    while (!atomic_load(&sim->quit)) {
+        stale |= runCommands(sim, snap, &view, &density, lines);
+
+        int running = atomic_load(&sim->running);
+        int wait = atomic_load(&sim->wait);
+        Uint32 now = SDL_GetTicks();
+        if (running && now - lastStep >= (Uint32)wait) {
+            updateState(&sim->state);
+            markDensity(&sim->state, &density);
+            markLines(&sim->state, view, lines);
+            lastStep = now;
+            stale = 1;
+        }
+
+        if (stale && (wait > 0 || !running || now - lastPublish >= MAIN_WAIT)) {
+            frame_t* frame = tripleBack(sim->frames);
+            renderView(view, viewSource(&sim->state, scratch), &density, frame->pixels);
+            memcpy(frame->lines, lines, view.height);
+            memset(lines, 0, view.height);
+            frame->generation = sim->state.generation;
+            frame->sequence = ++sequence;
+            triplePublish(sim->frames);
+            lastPublish = now;
+            stale = 0;
+        }
+
+        if (!running || wait > 0) {
+            SDL_Delay(1);
+        }
+    }
+
+    // Waits for a save still being written
+    snapshotFree(snap);
+    freeDensity(density);
+    free(lines);
+    if (scratch.data != NULL) {
+        freePackedBoard(scratch);
+    }
+    return NULL;
+}
+
+/*
+ * Display loop, the generations are computed by the simulation thread
+ * The newest published generation is drawn, the other ones are skipped
+ */
+void guiLoop(game_state_t* state) {
     int quit = 0;
     int running = 0;
-    int elapsed = 0;
     int wait = 500;
     SDL_Event event;
     int mouseDown = 0;
     int keyDown = 0;
+    int width = state->currBoard.width;
+    int height = state->currBoard.height;
+
+    view_t view = screenView();
+    simulation_t sim;
+    sim.state = *state;
+    sim.frames = tripleCreate(view.width, view.height);
+    sim.commandCount = 0;
+    sim.view = view;
+    sim.viewChanged = 0;
+    pthread_mutex_init(&sim.lock, NULL);
+    atomic_init(&sim.running, running);
+    atomic_init(&sim.wait, wait);
+    atomic_init(&sim.quit, 0);
+    int err = pthread_create(&sim.thread, NULL, simulationLoop, &sim);
+    assert(err == 0);
 
-    updateScreen(state.currBoard);
-    updateTexts(running, wait, state.generation);
+    long long generation = -1;
+    long long sequence = 0;
+    int textsChanged = 1;
 
     while (!quit) {
         Uint32 tmpTicks = SDL_GetTicks();
 
-        SDL_PollEvent(&event);
-        switch (event.type) {
-            case SDL_QUIT:
-                quit = 1;
-                break;
-            case SDL_MOUSEBUTTONDOWN:
-                // Fill or empty a cell
-                if (!mouseDown && !running) {
-                    Point p = getPointFromScreen(event.button.x, event.button.y, state.currBoard.size);
-                    if (p.i == -2) {
-                        // -2 is button pressed
-                        saveBoard(state.currBoard, state.currBoard.size);
-                    } else if (p.i > -1) {
-                        
-                        state.currBoard.data[idx(p.i, p.j, state.currBoard.size)] = !state.currBoard.data[idx(p.i, p.j, state.currBoard.size)];
+        while (SDL_PollEvent(&event)) {
+            switch (event.type) {
+                case SDL_QUIT:
+                    quit = 1;
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                    // Wheel: zoom around the cursor
+                    if (event.button.button == SDL_BUTTON_WHEELUP || event.button.button == SDL_BUTTON_WHEELDOWN) {
+                        zoomScreen(event.button.button == SDL_BUTTON_WHEELUP, event.button.x, event.button.y);
+                        setView(&sim, screenView());
+                        break;
                     }
-                    updateScreen(state.currBoard);
-                    updateTexts(running, wait, state.generation);
+                    // Fill or empty a cell
+                    if (!mouseDown && !running && event.button.button == SDL_BUTTON_LEFT) {
+                        Point p = getPointFromScreen(event.button.x, event.button.y, width, height);
+                        if (p.i == -2) {
+                            // -2 is button pressed
+                            pushCommand(&sim, CMD_SAVE, 0, 0);
+                        } else if (p.i > -1) {
+                            pushCommand(&sim, CMD_TOGGLE, p.i, p.j);
+                        }
 
-                    mouseDown = 1;
-                }
-                break;
-            case SDL_MOUSEBUTTONUP:
-                mouseDown = 0;
-                break;
-            case SDL_KEYDOWN:
-                // space: run, up/down: speed, right: next state
-                if (!keyDown) {
-                    switch(event.key.keysym.sym) {
-                        case SDLK_SPACE:
-                            running = !running;
-                            updateTexts(running, wait, state.generation);
-                            break;
-                        case SDLK_UP:
-                            wait /= 2;
-                            if (wait < MIN_GEN_WAIT) {
-                                wait = MIN_GEN_WAIT;
-                            }
-                            updateTexts(running, wait, state.generation);
-                            break;
-                        case SDLK_DOWN:
-                            wait *= 2;
-                            updateTexts(running, wait, state.generation);
-                            break;
-                        case SDLK_RIGHT:
-                            if (!running) {
-                                updateState(&state);
-                                updateScreen(state.currBoard);
-                                updateTexts(running, wait, state.generation);
-                            }
-                            break;
-                        default:
-                            break;
+                        mouseDown = 1;
                     }
+                    break;
+                case SDL_MOUSEBUTTONUP:
+                    mouseDown = 0;
+                    break;
+                case SDL_KEYDOWN:
+                    // space: run, up/down: speed (up to unlimited), right: next state
+                    // +/-: zoom, w/a/s/d: move the view
+                    if (!keyDown) {
+                        view = screenView();
+                        switch(event.key.keysym.sym) {
+                            case SDLK_SPACE:
+                                running = !running;
+                                break;
+                            case SDLK_UP:
+                                if (wait == MIN_GEN_WAIT) {
+                                    wait = 0;
+                                } else if (wait > 0) {
+                                    wait = max(wait / 2, MIN_GEN_WAIT);
+                                }
+                                break;
+                            case SDLK_DOWN:
+                                wait = (wait == 0 ? MIN_GEN_WAIT : wait * 2);
+                                break;
+                            case SDLK_RIGHT:
+                                if (!running) {
+                                    pushCommand(&sim, CMD_STEP, 0, 0);
+                                }
+                                break;
+                            case SDLK_PLUS:
+                            case SDLK_EQUALS:
+                            case SDLK_KP_PLUS:
+                                zoomScreen(1, view.width / 2, view.height / 2);
+                                break;
+                            case SDLK_MINUS:
+                            case SDLK_KP_MINUS:
+                                zoomScreen(0, view.width / 2, view.height / 2);
+                                break;
+                            case SDLK_w:
+                                panScreen(-1, 0);
+                                break;
+                            case SDLK_s:
+                                panScreen(1, 0);
+                                break;
+                            case SDLK_a:
+                                panScreen(0, -1);
+                                break;
+                            case SDLK_d:
+                                panScreen(0, 1);
+                                break;
+                            default:
+                                break;
+                        }
+                        atomic_store(&sim.running, running);
+                        atomic_store(&sim.wait, wait);
+                        view_t moved = screenView();
+                        if (moved.zoom != view.zoom || moved.i0 != view.i0 || moved.j0 != view.j0) {
+                            setView(&sim, moved);
+                        }
+                        textsChanged = 1;
 
-                    keyDown = 1;
-                }
-                break;
-            case SDL_KEYUP:
-                keyDown = 0;
-                break;
+                        keyDown = 1;
+                    }
+                    break;
+                case SDL_KEYUP:
+                    keyDown = 0;
+                    break;
+            }
         }
 
-        // Play life game
-        if (running && elapsed >= wait && !quit) {
-            updateState(&state);
-            updateScreen(state.currBoard);
-            updateTexts(running, wait, state.generation);
-
-            elapsed = 0;
+        // Draw the newest generation, only its changed lines when the frame
+        // before it was drawn, the lines of the skipped frames are not known
+        if (tripleUpdate(sim.frames)) {
+            frame_t* frame = tripleFront(sim.frames);
+            updateScreenView(frame->pixels, (frame->sequence == sequence + 1 ? frame->lines : NULL));
+            sequence = frame->sequence;
+            textsChanged |= (frame->generation != generation);
+            generation = frame->generation;
         }
+        if (textsChanged && generation >= 0) {
+            updateTexts(running, wait, generation);
+            textsChanged = 0;
+        }
+
+        // One present per loop, nothing is pushed when nothing was drawn
+        presentScreen();
 
         // Main wait
         int spend = (SDL_GetTicks() - tmpTicks);
         if (spend < MAIN_WAIT) {
             SDL_Delay(MAIN_WAIT - spend);
         }
-        elapsed += MAIN_WAIT;
     }
+
+    atomic_store(&sim.quit, 1);
+    pthread_join(sim.thread, NULL);
+    *state = sim.state;
+    pthread_mutex_destroy(&sim.lock);
+    tripleFree(sim.frames);
+}
+
+/*
+ * Render the current board in the next frame of the export
+ */
+double exportState(exporter_t* exp, game_state_t* state, view_t view, density_t* density, packed_board_t scratch) {
+    renderView(view, viewSource(state, scratch), density, exportBuffer(exp));
+    return exportFrame(exp, state->generation);
+}
+
+/*
+ * Print the available counters and the metrics derived from them for the given
+ * number of cells computed, the bytes are the LLC misses times the line size
+ */
+void printCounters(counters_t* counters, const uint64_t* values, double cells) {
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (counterAvailable(counters, c)) {
+            printf("%s: %llu, ", counterName(c), (unsigned long long)values[c]);
+        }
+    }
+    if (counterAvailable(counters, COUNTER_CYCLES) && counterAvailable(counters, COUNTER_INSTRUCTIONS)) {
+        printf("IPC: %.3f, ", (double)values[COUNTER_INSTRUCTIONS] / (values[COUNTER_CYCLES] > 0 ? values[COUNTER_CYCLES] : 1));
+    }
+    if (counterAvailable(counters, COUNTER_CYCLES)) {
+        printf("cycles/cell: %.4f, ", values[COUNTER_CYCLES] / cells);
+    }
+    if (counterAvailable(counters, COUNTER_BRANCH_MISSES)) {
+        printf("branch misses/cell: %.5f, ", values[COUNTER_BRANCH_MISSES] / cells);
+    }
+    if (counterAvailable(counters, COUNTER_LLC_MISSES)) {
+        printf("bytes/cell: %.4f, ", values[COUNTER_LLC_MISSES] * (double)COUNTER_LINE / cells);
+    }
+    printf("ns/cell: %.4f\n", values[COUNTER_TASK_CLOCK] / cells);
 }
 
-void perfLoop(game_state_t state, int maxGen) {
+void perfLoop(game_state_t* state, options_t* opts) {
+    int maxGen = opts->performance;
+    char* output = opts->output;
+    long long checkpoint = opts->checkpoint;
     double totalDur = 0;
     double minDur = DBL_MAX;
     double maxDur = DBL_MIN;
-    struct timeval begin, end;
 
-    while (state.generation < maxGen) {
-        gettimeofday(&begin, 0);
+    // Frames of the whole board, rendered here then encoded by the export thread
+    exporter_t* exp = NULL;
+    view_t view;
+    density_t density;
+    int width = state->currBoard.width;
+    int height = state->currBoard.height;
+    packed_board_t scratch = { NULL, width, height, 0, NULL, 0 };
+    double exportStall = 0;
+    if ((strcmp(opts->exportTarget, "") || opts->cycles > 0)
+            && state->engine != ENGINE_PACKED && state->engine != ENGINE_TEMPORAL && state->engine != ENGINE_TILES) {
+        scratch = allocPackedBoard(width, height);
+    }
+    if (strcmp(opts->exportTarget, "")) {
+        view = fitView(width, height, opts->exportSize, opts->exportSize);
+        density = allocDensity(width, height);
+        trackChanges(state);
+        // Created first, the texts must not be printed in a Y4M stream on stdout
+        exp = exportCreate(opts->exportTarget, view.width, view.height);
+    }
 
-        updateState(&state);
+    if (state->engine == ENGINE_CHAR) {
+        printf("Engine: char, kernel: %s\n", kernelName(getKernel()));
+    } else if (state->engine == ENGINE_TEMPORAL) {
+        printf("Engine: temporal, %d generations per pass\n", (opts->cycles > 0 ? 1 : state->blockGens));
+    } else {
+        printf("Engine: %s\n", engineNames[state->engine]);
+    }
+    char rule[RULE_LENGTH];
+    formatRule(getRule(), rule, sizeof(rule));
+    if (ruleName(getRule()) != NULL) {
+        printf("Rule: %s (%s)\n", rule, ruleName(getRule()));
+    } else {
+        printf("Rule: %s\n", rule);
+    }
+    if (getBoundary() != BOUNDARY_DEAD) {
+        printf("Boundary: %s\n", boundaryName(getBoundary()));
+    }
+
+    // A board loaded from a binary file can start at any generation
+    long long first = state->generation;
+    long long last = first + maxGen;
+
+    snapshot_t* snap = NULL;
+    char* checkpointFile = (strcmp(output, "") ? output : "checkpoint.lgb");
+    long long nextCheckpoint = first + checkpoint;
+    double totalStall = 0;
+    double maxStall = 0;
+    if (checkpoint > 0) {
+        snap = snapshotCreate();
+    }
+
+    // Counters read around each generation, outside of the timing
+    counters_t* counters = NULL;
+    uint64_t before[COUNTER_COUNT], after[COUNTER_COUNT], totals[COUNTER_COUNT] = { 0 };
+    double cellsPerGen = (double)width * height;
+    if (strcmp(opts->counters, "")) {
+        counters = countersOpen();
+    }
+
+    long long nextExport = first;
+    int blockGens = state->blockGens;
+    if (exp != NULL) {
+        exportStall += exportState(exp, state, view, &density, scratch);
+        nextExport += opts->exportEvery;
+    }
 
-        gettimeofday(&end, 0);
-        long s = end.tv_sec - begin.tv_sec;
-        long micro = end.tv_usec - begin.tv_usec;
-        double dur = s*1e+3 + micro*1e-3;
+    // Hashed after each generation, outside of the timing
+    cycle_t cycle;
+    double hashDur = 0;
+    if (opts->cycles > 0) {
+        cycle = allocCycle(width, height, opts->cycles);
+        trackChanges(state);
+        cycleUpdate(&cycle, viewSource(state, scratch), state->generation);
+    }
+
+    while (state->generation < last) {
+        // The temporal engine stops on the exported generations, and on each
+        // generation while a period is searched, its passes would skip the
+        // first generation of the period
+        long long stop = (exp != NULL ? min(last, nextExport) : last);
+        if (opts->cycles > 0) {
+            stop = state->generation + 1;
+        }
+        if (state->engine == ENGINE_TEMPORAL) {
+            state->blockGens = min(blockGens, stop - state->generation);
+        }
+        long long gen = state->generation;
+        if (counters != NULL) {
+            countersRead(counters, before);
+        }
+        double begin = benchClock();
+
+        updateState(state);
+
+        double dur = benchClock() - begin;
+        if (counters != NULL) {
+            countersRead(counters, after);
+            for (int c = 0; c < COUNTER_COUNT; c++) {
+                after[c] -= before[c];
+                totals[c] += after[c];
+            }
+            if (!strcmp(opts->counters, "gen")) {
+                printf("\nGen %lld counters: ", state->generation);
+                printCounters(counters, after, cellsPerGen * (state->generation - gen));
+            }
+        }
 
         totalDur += dur;
         maxDur = (dur > maxDur ? dur : maxDur);
         minDur = (dur < minDur ? dur : minDur);
 
-        if (state.generation == 1 || state.generation % 100 == 0 || state.generation == maxGen) {
-            printf("\rGen: %d/%d, last: %.4f ms, avg: %.4f ms, min: %.4f ms, max: %.4f ms    ", state.generation, maxGen, dur, totalDur/state.generation, minDur, maxDur);
+        if (state->generation == first + 1 || state->generation % 100 == 0 || state->generation == last) {
+            printf("\rGen: %lld/%lld, last: %.4f ms, avg: %.4f ms, min: %.4f ms, max: %.4f ms    ", state->generation, last, dur, totalDur/(state->generation - first), minDur, maxDur);
             fflush(stdout);
         }
+
+        if (exp != NULL) {
+            markDensity(state, &density);
+            if (state->generation >= nextExport) {
+                exportStall += exportState(exp, state, view, &density, scratch);
+                nextExport += opts->exportEvery;
+            }
+        }
+
+        if (snap != NULL && state->generation >= nextCheckpoint) {
+            double stall = snapshotState(snap, state, checkpointFile);
+            totalStall += stall;
+            maxStall = (stall > maxStall ? stall : maxStall);
+            printf("\nCheckpoint of gen %lld to %s, stall: %.4f ms\n", state->generation, checkpointFile, stall);
+            while (nextCheckpoint <= state->generation) {
+                nextCheckpoint += checkpoint;
+            }
+        }
+
+        if (opts->cycles > 0) {
+            double hashBegin = benchClock();
+            markCycle(state, &cycle);
+            int periodic = cycleUpdate(&cycle, viewSource(state, scratch), state->generation);
+            hashDur += benchClock() - hashBegin;
+            if (periodic) {
+                printf("\nPeriod %lld reached at generation %lld", cycle.period, cycle.found);
+                break;
+            }
+        }
     }
 
     printf("\nTotal calculation duration: %f s\n", totalDur*1e-3);
+    if (opts->cycles > 0) {
+        printf("Cycle detection: %.4f ms\n", hashDur);
+        freeCycle(cycle);
+    }
+    if (counters != NULL) {
+        printf("Counters: ");
+        printCounters(counters, totals, cellsPerGen * (state->generation - first));
+        countersClose(counters);
+    }
+    if (snap != NULL) {
+        snapshotWait(snap);
+        printf("Checkpoints: %d, total stall: %.4f ms, max stall: %.4f ms, background writing: %.4f ms\n", snapshotCount(snap), totalStall, maxStall, snapshotWriteTime(snap));
+        snapshotFree(snap);
+    }
+    if (exp != NULL) {
+        exportWait(exp);
+        printf("Frames: %d of %dx%d to %s, total stall: %.4f ms, background encoding: %.4f ms\n", exportCount(exp), view.width, view.height, opts->exportTarget, exportStall, exportWriteTime(exp));
+        exportFree(exp);
+        freeDensity(density);
+    }
+    if (scratch.data != NULL) {
+        freePackedBoard(scratch);
+    }
+    if (state->engine == ENGINE_TILES) {
+        printf("Skipped tiles: %.2f %%\n", 100.0 * state->tiles.skipped / state->tiles.total);
+    } else if (state->engine == ENGINE_SPARSE) {
+        printf("Population: %llu, chunks: %zu\n", (unsigned long long)sparsePopulation(state->universe), sparseChunks(state->universe));
+    }
+    if (strcmp(output, "")) {
+        saveState(state, output);
+    }
 }
 
-int main(int argc, char** argv) {
-    srand(time(NULL));
+void jumpLoop(game_state_t* state, long long n, char* output) {
+    struct timeval begin, end;
+
+    gettimeofday(&begin, 0);
+    jumpState(state, n);
+    gettimeofday(&end, 0);
+
+    double dur = (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec)*1e-6;
+    printf("Gen: %lld, population: %lld, duration: %f s\n", state->generation, statePopulation(state), dur);
+    if (state->engine == ENGINE_HASHLIFE) {
+        printf("Nodes: %zu\n", hashlifeNodes(state->life));
+    }
+    if (strcmp(output, "")) {
+        saveState(state, output);
+    }
+}
+
+/*
+ * Run -p generations of an ensemble of random boards, print the throughput
+ * and write the results of each board
+ */
+void ensembleLoop(options_t* opts) {
+    int width = (opts->width > 0 ? opts->width : DEFAULT_SIZE);
+    int height = (opts->height > 0 ? opts->height : width);
+    ensemble_t ensemble = allocEnsemble(width, height, opts->ensemble);
+    randomEnsemble(&ensemble, (opts->random > 0 ? opts->random : 1), opts->density, opts->seed);
+
+    double begin = benchClock();
+    stepEnsemble(&ensemble, opts->performance);
+    double dur = benchClock() - begin;
+    ensemblePopulation(&ensemble);
+
+    int periodic = 0, extinct = 0;
+    for (int b = 0; b < ensemble.boards; b++) {
+        periodic += (ensemble.period[b] > 0);
+        extinct += (ensemble.extinction[b] >= 0);
+    }
+    double cells = (double)width * height * ensemble.boards * opts->performance;
+    printf("Boards: %d of %dx%d, generations: %d, duration: %f s, %.0f cells per second\n",
+           ensemble.boards, width, height, opts->performance, dur*1e-3, cells / (dur*1e-3));
+    printf("Periodic: %d, extinct: %d, seed: %lld\n", periodic, extinct, opts->seed);
+
+    writeEnsembleCsv(ensemble, opts->output);
+    printf("Results saved to %s\n", opts->output);
+    freeEnsemble(ensemble);
+}
+
+/*
+ * Run a census of random soups and print the most common objects
+ */
+void censusLoop(options_t* opts) {
+    int width = (opts->width > 0 ? opts->width : CENSUS_SOUP);
+    int height = (opts->height > 0 ? opts->height : width);
+    long long maxGens = (opts->performance > 0 ? opts->performance : CENSUS_MAX_GENERATIONS);
 
-    int size = 0;
-    int random = 0;
-    int performance = 0;
-    char* file = "";
+    census_t census = runCensus(width, height, opts->census, maxGens, opts->density, opts->seed, 0);
+    printf("Soups: %lld of %dx%d, seed: %lld, threads: %d, duration: %f s, %.0f soups per second\n",
+           census.soups, width, height, opts->seed, census.threads, census.duration*1e-3, census.soups / (census.duration*1e-3));
+    printf("Unsettled after %lld generations: %lld, run on the plane: %lld, objects: %lld, kinds: %d\n",
+           maxGens, census.unsettled, census.plane, census.total, census.count);
+    printCensus(census, CENSUS_REPORT);
 
-    manageArguments(argc, argv, &size, &file, &random, &performance);
+    if (strcmp(opts->output, "")) {
+        writeCensusCsv(census, opts->output);
+        printf("Census saved to %s\n", opts->output);
+    }
+    freeCensus(census);
+}
+
+/*
+ * Select the rule given on the command line, loading a file selects its rule
+ * but the one given on the command line wins
+ */
+void applyRule(options_t* opts) {
+    if (strcmp(opts->rule, "")) {
+        rule_t rule;
+        parseRule(opts->rule, &rule);
+        setRule(rule);
+    }
+}
+
+/*
+ * Jump n generations with the board split in strips between processes, the
+ * process 0 loads the board, prints the results and saves the final board
+ */
+void distribLoop(options_t* opts) {
+    int wrap = (opts->boundary == BOUNDARY_TORUS || opts->boundary == BOUNDARY_KLEIN);
+    int procs = (opts->procs > 0 ? opts->procs : distribPeers(opts->peers));
+
+    // Loaded before the other processes are started, so a board too small
+    // for them stops the run before any link is open
+    packed_board_t packed;
+    memset(&packed, 0, sizeof(packed));
+    long long generation = 0;
+    if (opts->procs > 0 || opts->rank == 0) {
+        if (strcmp(opts->file, "") && isBinaryBoard(opts->file) && opts->random == 0) {
+            // The mapped board is sent without copy
+            binary_header_t header;
+            packed = mapBinaryBoard(opts->file, &header);
+            generation = header.generation;
+        } else {
+            board_t board = getBoard(opts->file, &opts->width, &opts->height);
+            if (opts->random > 0) {
+                randomBoard(board, opts->random, opts->density, opts->seed);
+                printf("Random board, seed: %lld\n", opts->seed);
+            }
+            packed = allocPackedBoard(board.width, board.height);
+            packBoard(board, packed);
+            freeBoard(board);
+        }
+        applyRule(opts);
+        if (packed.height < procs) {
+            errorExit("Invalid arguments : the board has fewer rows than processes");
+        }
+    }
+
+    distrib_t* d = (opts->procs > 0 ? distribFork(opts->procs, wrap) : distribConnect(opts->peers, opts->rank, wrap));
+    int rank = distribRank(d);
+    if (rank != 0 && packed.data != NULL) {
+        // Forked with the board of the process 0
+        freePackedBoard(packed);
+        memset(&packed, 0, sizeof(packed));
+    }
+
+    strip_t strip = scatterStrips(d, packed, generation);
+    if (rank == 0) {
+        freePackedBoard(packed);
+    }
+
+    struct timeval begin, end;
+    gettimeofday(&begin, 0);
+    stepStrips(d, &strip, opts->jump);
+    long long population = stripsPopulation(d, strip);
+    gettimeofday(&end, 0);
+
+    double dur = (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec)*1e-6;
+    if (rank == 0) {
+        printf("Gen: %lld, population: %lld, duration: %f s\n", strip.generation, population, dur);
+        printf("Processes: %d, rows of the first strip: %d\n", distribProcs(d), strip.curr.height);
+    }
+    gatherStrips(d, strip, opts->output);
+    if (rank == 0 && strcmp(opts->output, "")) {
+        printf("Board saved to %s\n", opts->output);
+    }
+
+    freeStrip(strip);
+    int failures = distribFree(d);
+    if (failures > 0) {
+        fprintf(stderr, "%d processes failed\n", failures);
+    }
+    exit(failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/*
+ * Compare kernels with the sequential one, return the number of kernels which differ
+ */
+int checkLoop(board_t board, char* kernel, int generations) {
+    int failures = 0;
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if ((!strcmp(kernel, "all") && kernelSupported(k)) || (strcmp(kernel, "all") && k == getKernel())) {
+            int mismatch = checkKernel(board, k, generations);
+            if (mismatch) {
+                printf("Kernel %s: differs from seq at generation %d\n", kernelName(k), mismatch);
+                failures += 1;
+            } else {
+                printf("Kernel %s: identical to seq during %d generations\n", kernelName(k), generations);
+            }
+        }
+    }
+    return failures;
+}
+
+/*
+ * Measure one configuration : the warmup generations are run, then the
+ * generations are timed one by one, during BENCH_TIME_MS at least
+ */
+bench_result_t benchConfig(int engine, int width, int height, double density, int threads) {
+    bench_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.engine = engineNames[engine];
+    result.kernel = (engine == ENGINE_CHAR ? kernelName(getKernel()) : "-");
+    result.width = width;
+    result.height = height;
+    result.density = density;
+    result.threads = threads;
+    result.warmup = BENCH_WARMUP;
+
+    board_t board = allocBoard(width, height);
+    randomBoard(board, 1, density, BENCH_SEED);
+    packed_board_t none;
+    memset(&none, 0, sizeof(none));
+    game_state_t state = createState(board, none, engine, TEMPORAL_DEFAULT_GENS);
+
+    while (state.generation < BENCH_WARMUP) {
+        updateState(&state);
+    }
+
+    // The temporal engine advances several generations per update, its
+    // latency is the update divided by them
+    double samples[BENCH_MAX_GENERATIONS];
+    int count = 0;
+    long long first = state.generation;
+    double begin = benchClock();
+    while (count < BENCH_MAX_GENERATIONS && (count < BENCH_MIN_GENERATIONS || benchClock() - begin < BENCH_TIME_MS)) {
+        long long gen = state.generation;
+        double start = benchClock();
+        updateState(&state);
+        samples[count++] = (benchClock() - start) / (state.generation - gen);
+    }
+
+    benchStats(&result, samples, count);
+    result.generations = state.generation - first;
+    freeState(state);
+    return result;
+}
+
+/*
+ * Run every configuration of the benchmark and write the results
+ * The boards are generated with a fixed seed, so the runs are comparable
+ */
+void benchLoop(options_t* opts) {
+    bench_result_t* results = malloc(BENCH_MAX_RESULTS * sizeof(bench_result_t));
+    assert(results != NULL);
+    int count = 0;
+    int processors = benchThreads(0);
+    int kernel = getKernel();
+
+    for (size_t s = 0; s < sizeof(benchSizes) / sizeof(int); s++) {
+        int width = (opts->width > 0 ? opts->width : benchSizes[s]);
+        int height = (opts->height > 0 ? opts->height : benchSizes[s]);
+        for (size_t d = 0; d < sizeof(benchDensities) / sizeof(double); d++) {
+            for (size_t e = 0; e < sizeof(benchEngines) / sizeof(int); e++) {
+                int engine = benchEngines[e];
+                for (int k = 0; k < KERNEL_COUNT; k++) {
+                    // Only the char engine has several kernels
+                    if (!kernelSupported(k) || (engine != ENGINE_CHAR && k != kernel)) {
+                        continue;
+                    }
+                    selectKernel(kernelName(k));
+
+                    // 1, 2, 4, ... threads, and all of them
+                    for (int threads = 1; ; threads *= 2) {
+                        threads = min(threads, processors);
+                        benchThreads(threads);
+                        bench_result_t r = benchConfig(engine, width, height, benchDensities[d], threads);
+                        printf("%s/%s, size %dx%d, density %.2f, %d threads : median %.4f ms, p95 %.4f ms, p99 %.4f ms, %.3g cells/s\n",
+                               r.engine, r.kernel, r.width, r.height, r.density, r.threads, r.median, r.p95, r.p99, r.cellsPerSecond);
+                        if (count < BENCH_MAX_RESULTS) {
+                            results[count++] = r;
+                        }
+                        if (threads == processors) {
+                            break;
+                        }
+                    }
+                }
+                selectKernel(kernelName(kernel));
+            }
+        }
+        if (opts->width > 0) {
+            break;
+        }
+    }
+
+    benchThreads(processors);
+    writeBenchResults(opts->bench, results, count);
+    printf("%d configurations written to %s\n", count, opts->bench);
+    free(results);
+}
+
+int main(int argc, char** argv) {
+    options_t opts = { 0, 0, "", 0, 0, 0, ENGINE_CHAR, TEMPORAL_DEFAULT_GENS, "auto", 0, "", 0, "", 1, EXPORT_SIZE, "", "", "", BOUNDARY_DEAD, 0, "", 0, 0, 0, 0, RANDOM_DENSITY, -1 };
+    manageArguments(argc, argv, &opts);
+    // Without --seed, each run draws other boards, but a census is comparable to the others
+    if (opts.seed < 0) {
+        opts.seed = (opts.census > 0 ? CENSUS_SEED : (long long)time(NULL));
+    }
+    // The unbounded planes and the temporal halos only know dead cells around the board
+    if (opts.boundary != BOUNDARY_DEAD && (strcmp(opts.bench, "") || (opts.engine != ENGINE_CHAR
+            && opts.engine != ENGINE_PACKED && opts.engine != ENGINE_TILES))) {
+        errorExit("Invalid arguments : -b needs the char, packed or tiles engine");
+    }
+    if (strcmp(opts.bench, "")) {
+        benchLoop(&opts);
+        exit(EXIT_SUCCESS);
+    }
+    if (opts.procs > 0 || strcmp(opts.peers, "")) {
+        if (opts.jump == 0 || (opts.procs > 0 && strcmp(opts.peers, ""))) {
+            errorExit("Invalid arguments : --procs and --peers need -j, not both");
+        }
+        distribLoop(&opts);
+    }
+    if (opts.census > 0) {
+        size_t length = strlen(opts.output);
+        if (strcmp(opts.file, "") || (length > 0 && (length <= 4 || strcmp(&opts.output[length - 4], ".csv")))) {
+            errorExit("Invalid arguments : --census can't load a board, and writes its report to a .csv file");
+        }
+        censusLoop(&opts);
+        exit(EXIT_SUCCESS);
+    }
+    if (opts.ensemble > 0) {
+        size_t length = strlen(opts.output);
+        if (opts.performance == 0 || length <= 4 || strcmp(&opts.output[length - 4], ".csv") || strcmp(opts.file, "")) {
+            errorExit("Invalid arguments : --ensemble needs -p and -o <file.csv>, without -f");
+        }
+        ensembleLoop(&opts);
+        exit(EXIT_SUCCESS);
+    }
+    if (opts.cycles > 0 && (opts.performance == 0 || opts.engine == ENGINE_HASHLIFE || opts.engine == ENGINE_SPARSE)) {
+        errorExit("Invalid arguments : --cycles needs -p and the char, packed, tiles or temporal engine");
+    }
+    if (strcmp(opts.exportTarget, "") && opts.performance == 0) {
+        errorExit("Invalid arguments : -x needs -p");
+    } else if (strcmp(opts.exportTarget, "") && !strcmp(opts.kernel, "all")) {
+        errorExit("Invalid arguments : -x can't be used with -k all");
+    }
 
     // Create board
-    board_t board1 = getBoard(file, &size);
-    board_t board2 = allocBoard(size);
-    if (random > 0) {
-        randomBoard(board1, random);
+    board_t board;
+    packed_board_t packed;
+    memset(&packed, 0, sizeof(packed));
+    long long generation = 0;
+    if (strcmp(opts.file, "") && isBinaryBoard(opts.file)) {
+        // The mapped board is used without copy by the bit-packed engines
+        binary_header_t header;
+        packed = mapBinaryBoard(opts.file, &header);
+        generation = header.generation;
+        opts.width = packed.width;
+        opts.height = packed.height;
+        board.width = packed.width;
+        board.height = packed.height;
+        board.data = NULL;
+
+        int engine = (opts.performance > 0 && !strcmp(opts.kernel, "all") ? ENGINE_CHAR : opts.engine);
+        if ((engine != ENGINE_PACKED && engine != ENGINE_TEMPORAL) || opts.random > 0 || opts.check > 0) {
+            board = allocBoard(opts.width, opts.height);
+            unpackBoard(packed, board);
+            freePackedBoard(packed);
+            packed.data = NULL;
+        }
+    } else {
+        board = getBoard(opts.file, &opts.width, &opts.height);
+    }
+    if (opts.random > 0) {
+        randomBoard(board, opts.random, opts.density, opts.seed);
+        printf("Random board, seed: %lld\n", opts.seed);
     }
-    game_state_t state = { board1, board2, 0 };
-    
-    if (performance == 0) {
-        initScreen(size);
+    applyRule(&opts);
+
+    if (opts.check > 0) {
+        int failures = checkLoop(board, opts.kernel, opts.check);
+        freeBoard(board);
+        exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+    } else if (opts.jump > 0) {
+        game_state_t state = createState(board, packed, opts.engine, opts.blockGens);
+        state.generation = generation;
+        jumpLoop(&state, opts.jump, opts.output);
+        freeState(state);
+    } else if (opts.performance == 0) {
+        game_state_t state = createState(board, packed, opts.engine, opts.blockGens);
+        state.generation = generation;
+        initScreen(opts.width, opts.height);
 
         // Main loop
-        guiLoop(state);
+        guiLoop(&state);
 
         closeScreen();
+        freeState(state);
+    } else if (!strcmp(opts.kernel, "all")) {
+        // Same initial board for every kernel
+        for (int k = 0; k < KERNEL_COUNT; k++) {
+            if (kernelSupported(k)) {
+                selectKernel(kernelName(k));
+
+                board_t copy = allocBoard(opts.width, opts.height);
+                copyBoard(board, copy);
+                game_state_t state = createState(copy, packed, ENGINE_CHAR, opts.blockGens);
+                state.generation = generation;
+                perfLoop(&state, &opts);
+                freeState(state);
+            }
+        }
+        freeBoard(board);
     } else {
-        perfLoop(state, performance);
+        game_state_t state = createState(board, packed, opts.engine, opts.blockGens);
+        state.generation = generation;
+        perfLoop(&state, &opts);
+        freeState(state);
     }
 
-    // Free all memory
-    freeBoard(state.currBoard);
-    freeBoard(state.nextBoard);
-
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,533 @@
+/*
+ * Title    : Game of life / pattern
+ * Desc     : Readers and writers for the pattern file formats (plain text, RLE, Life 1.06)
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include "board.h"
+#include "pattern.h"
+#include "binary.h"
+#include "rule.h"
+#include "math.h"
+
+#define READ_BUFFER (1 << 16)
+#define RLE_LINE 70
+/*
+ * Largest coordinate or size of a pattern, its board and halo fit in an int
+ */
+#define PATTERN_MAX (INT_MAX - 2)
+
+/*
+ * Buffered reader, the file is read by blocks and parsed in a single pass
+ */
+typedef struct reader {
+    FILE* file;
+    char* buffer;
+    size_t pos;
+    size_t length;
+} reader_t;
+
+/*
+ * Buffered RLE writer, the lines are wrapped at RLE_LINE characters
+ */
+typedef struct writer {
+    FILE* file;
+    char* buffer;
+    size_t length;
+    int column;
+} writer_t;
+
+/*
+ * Read the next block of the file, return 0 at the end of the file
+ */
+static int fillReader(reader_t* r) {
+    r->length = fread(r->buffer, 1, READ_BUFFER, r->file);
+    r->pos = 0;
+    return r->length > 0;
+}
+
+/*
+ * Return the next character without consuming it, EOF at the end of the file
+ */
+static inline int peekChar(reader_t* r) {
+    if (r->pos == r->length && !fillReader(r)) {
+        return EOF;
+    }
+    return (unsigned char)r->buffer[r->pos];
+}
+
+/*
+ * Return the next character, EOF at the end of the file
+ */
+static inline int nextChar(reader_t* r) {
+    int c = peekChar(r);
+    if (c != EOF) {
+        r->pos += 1;
+    }
+    return c;
+}
+
+/*
+ * Read a line, truncated to length-1 characters, return 0 at the end of the file
+ */
+static int readLine(reader_t* r, char* line, int length) {
+    int n = 0;
+    int c = nextChar(r);
+    if (c == EOF) {
+        return 0;
+    }
+    while (c != EOF && c != '\n') {
+        if (n < length - 1 && c != '\r') {
+            line[n++] = c;
+        }
+        c = nextChar(r);
+    }
+    line[n] = 0;
+    return 1;
+}
+
+/*
+ * Read a signed integer after optional blanks, return 0 if there is none
+ * A value larger than PATTERN_MAX is reported as a parse error
+ */
+static int readInt(reader_t* r, long* value) {
+    int c = peekChar(r);
+    while (c == ' ' || c == '\t' || c == '\r') {
+        nextChar(r);
+        c = peekChar(r);
+    }
+
+    int sign = 1;
+    if (c == '-' || c == '+') {
+        sign = (c == '-' ? -1 : 1);
+        nextChar(r);
+        c = peekChar(r);
+    }
+    if (!isdigit(c)) {
+        return 0;
+    }
+
+    *value = 0;
+    while (isdigit(c)) {
+        *value = *value * 10 + (c - '0');
+        if (*value > PATTERN_MAX) {
+            fprintf(stderr, "Invalid pattern coordinate, larger than %d\n", PATTERN_MAX);
+            exit(EXIT_FAILURE);
+        }
+        nextChar(r);
+        c = peekChar(r);
+    }
+    *value *= sign;
+    return 1;
+}
+
+/*
+ * Set n cells from (i, j) to alive, the cells outside of the board are ignored
+ */
+static void setRun(board_t board, long i, long j, long n) {
+    if (i < 0 || i >= board.height) {
+        return;
+    }
+    long from = max(j, 0L);
+    long to = min(j + n, (long)board.width);
+    if (from < to) {
+        memset(&board.data[boardIdx(i, 0, board.width) + from], 1, to - from);
+    }
+}
+
+/*
+ * Allocate the board for a pattern of (w x h) cells
+ * The dimensions of the pattern are used unless the board dimensions are given
+ * A pattern larger than PATTERN_MAX cells is reported as a parse error
+ */
+static board_t patternBoard(int* width, int* height, long w, long h) {
+    if (w < 0 || h < 0 || w > PATTERN_MAX || h > PATTERN_MAX) {
+        fprintf(stderr, "Invalid pattern size %ldx%ld, larger than %d\n", w, h, PATTERN_MAX);
+        exit(EXIT_FAILURE);
+    }
+    if (*width == 0 || *height == 0) {
+        *width = (int)w;
+        *height = (int)h;
+    }
+    *width = max(*width, MIN_SIZE);
+    *height = max(*height, MIN_SIZE);
+    return allocBoard(*width, *height);
+}
+
+/*
+ * Plain text : the size (or "width height") on the first line, then one '0'
+ * or '1' per cell
+ */
+static board_t readText(reader_t* r, int* width, int* height) {
+    char line[32];
+    long w = 0;
+    long h = 0;
+    if (readLine(r, line, sizeof(line)) && sscanf(line, "%ld %ld", &w, &h) == 1) {
+        h = w;
+    }
+    board_t board = patternBoard(width, height, w, h);
+
+    int i = 0;
+    int j = 0;
+    int c;
+    while (i < *height && (c = nextChar(r)) != EOF) {
+        if (c == '\n') {
+            i += 1;
+            j = 0;
+        } else if (c != '\r' && j < *width) {
+            board.data[boardIdx(i, j, *width)] = (c != '0');
+            j += 1;
+        }
+    }
+
+    return board;
+}
+
+/*
+ * RLE : '#' comment lines, a "x = w, y = h, rule = B3/S23" header, then runs of
+ * 'b' (dead), 'o' (alive) and '$' (end of row), terminated by '!'
+ * The rule of the header is selected with setRule, unless it isn't supported
+ */
+static board_t readRLE(reader_t* r, int* width, int* height) {
+    char line[256];
+    long w = 0;
+    long h = 0;
+    while (readLine(r, line, sizeof(line))) {
+        if (line[0] != '#') {
+            if (sscanf(line, " x = %ld , y = %ld", &w, &h) != 2 || w < 0 || h < 0) {
+                fprintf(stderr, "Invalid RLE header: %s\n", line);
+                exit(EXIT_FAILURE);
+            }
+
+            char text[RULE_LENGTH];
+            const char* field = strstr(line, "rule");
+            rule_t rule;
+            if (field != NULL && sscanf(field, "rule = %31[^ \t\r\n]", text) == 1) {
+                if (parseRule(text, &rule)) {
+                    setRule(rule);
+                } else {
+                    fprintf(stderr, "Unsupported RLE rule %s, the current rule is kept\n", text);
+                }
+            }
+            break;
+        }
+    }
+    board_t board = patternBoard(width, height, w, h);
+
+    long i = (*height - h) / 2;
+    long j0 = (*width - w) / 2;
+    long j = j0;
+    long count = 0;
+    long longest = max(*width, *height);
+    int c;
+    while ((c = nextChar(r)) != EOF && c != '!') {
+        if (isdigit(c)) {
+            // A run never goes past the board, a longer one would overflow
+            count = count * 10 + (c - '0');
+            if (count > longest) {
+                fprintf(stderr, "Invalid RLE run count, longer than the board of %dx%d\n", *width, *height);
+                exit(EXIT_FAILURE);
+            }
+            continue;
+        }
+
+        long n = (count > 0 ? count : 1);
+        if (c == '$') {
+            i += n;
+            j = j0;
+        } else if (c == 'b' || c == '.') {
+            j += n;
+        } else if (isalpha(c)) {
+            // 'o' and the states of multi-state rules are alive
+            setRun(board, i, j, n);
+            j += n;
+        } else {
+            // Blanks between the runs
+            continue;
+        }
+        count = 0;
+    }
+
+    return board;
+}
+
+/*
+ * Life 1.06 : '#' lines, then one "x y" line per living cell
+ * The coordinates are kept until the bounding box of the pattern is known
+ */
+static board_t readLife106(reader_t* r, int* width, int* height) {
+    size_t count = 0;
+    size_t capacity = 1024;
+    long* cells = malloc(capacity * 2 * sizeof(long));
+    assert(cells != NULL);
+
+    long minX = 0, maxX = -1, minY = 0, maxY = -1;
+    int c;
+    while ((c = peekChar(r)) != EOF) {
+        long x, y;
+        if (c != '#' && readInt(r, &x) && readInt(r, &y)) {
+            if (count == capacity) {
+                capacity *= 2;
+                cells = realloc(cells, capacity * 2 * sizeof(long));
+                assert(cells != NULL);
+            }
+            cells[2*count] = x;
+            cells[2*count+1] = y;
+            if (count == 0) {
+                minX = maxX = x;
+                minY = maxY = y;
+            }
+            minX = min(minX, x);
+            maxX = max(maxX, x);
+            minY = min(minY, y);
+            maxY = max(maxY, y);
+            count += 1;
+        }
+        // Skip the rest of the line
+        while ((c = nextChar(r)) != EOF && c != '\n');
+    }
+
+    board_t board = patternBoard(width, height, maxX - minX + 1, maxY - minY + 1);
+
+    long offsetI = (*height - (maxY - minY + 1)) / 2 - minY;
+    long offsetJ = (*width - (maxX - minX + 1)) / 2 - minX;
+    for (size_t k = 0; k < count; k++) {
+        setRun(board, cells[2*k+1] + offsetI, cells[2*k] + offsetJ, 1);
+    }
+
+    free(cells);
+    return board;
+}
+
+/*
+ * Return the format of a pattern file from its extension (.txt, .rle, .lif, .life, .lgb)
+ * If the extension is unknown, the format is guessed from the first bytes of the
+ * file, header can be NULL to only use the extension
+ */
+int patternFormat(const char* filename, const char* header, int length) {
+    const char* dot = strrchr(filename, '.');
+    if (dot != NULL) {
+        char ext[8] = "";
+        for (int k = 0; k < 7 && dot[k+1]; k++) {
+            ext[k] = tolower((unsigned char)dot[k+1]);
+        }
+        if (!strcmp(ext, "rle")) {
+            return FORMAT_RLE;
+        } else if (!strcmp(ext, "lif") || !strcmp(ext, "life")) {
+            return FORMAT_LIFE106;
+        } else if (!strcmp(ext, "txt")) {
+            return FORMAT_TEXT;
+        } else if (!strcmp(ext, "lgb")) {
+            return FORMAT_BINARY;
+        }
+    }
+
+    if (header != NULL) {
+        if (length >= 8 && !strncmp(header, BINARY_MAGIC, 8)) {
+            return FORMAT_BINARY;
+        }
+        if (length >= 10 && !strncmp(header, "#Life 1.06", 10)) {
+            return FORMAT_LIFE106;
+        }
+        int k = 0;
+        while (k < length && isspace((unsigned char)header[k])) {
+            k += 1;
+        }
+        if (k < length && (header[k] == '#' || header[k] == 'x')) {
+            return FORMAT_RLE;
+        }
+    }
+
+    return FORMAT_TEXT;
+}
+
+/*
+ * Read a pattern file of any text format into a new board
+ * Board dimensions can be given, 0 to take them from the file
+ * RLE and Life 1.06 patterns are centered on the board, the rule of an RLE
+ * header is selected with setRule
+ */
+board_t readPattern(FILE* file, const char* filename, int* width, int* height) {
+    reader_t r = { file, malloc(READ_BUFFER), 0, 0 };
+    assert(r.buffer != NULL);
+
+    // The first block is used to detect the format, then parsed normally
+    fillReader(&r);
+
+    board_t board;
+    switch (patternFormat(filename, r.buffer, r.length)) {
+        case FORMAT_RLE:
+            board = readRLE(&r, width, height);
+            break;
+        case FORMAT_LIFE106:
+            board = readLife106(&r, width, height);
+            break;
+        default:
+            board = readText(&r, width, height);
+            break;
+    }
+
+    free(r.buffer);
+    return board;
+}
+
+/*
+ * Write the buffered output to the file
+ */
+static void flushWriter(writer_t* w) {
+    fwrite(w->buffer, 1, w->length, w->file);
+    w->length = 0;
+}
+
+/*
+ * Append a run to the RLE output, "3o", "b" or "2$"
+ */
+static void writeRun(writer_t* w, long n, char tag) {
+    char token[24];
+    int length = sizeof(token);
+    token[--length] = tag;
+    if (n > 1) {
+        do {
+            token[--length] = '0' + n % 10;
+            n /= 10;
+        } while (n > 0);
+    }
+    length = sizeof(token) - length;
+
+    if (w->length + length + 1 > READ_BUFFER) {
+        flushWriter(w);
+    }
+    if (w->column + length > RLE_LINE) {
+        w->buffer[w->length++] = '\n';
+        w->column = 0;
+    }
+    memcpy(&w->buffer[w->length], &token[sizeof(token) - length], length);
+    w->length += length;
+    w->column += length;
+}
+
+/*
+ * The header gives the whole board, so the pattern is reloaded at the same place
+ * Dead cells at the end of the rows and empty rows at the end are omitted
+ */
+static void writeRLE(board_t board, FILE* file) {
+    writer_t w = { file, malloc(READ_BUFFER), 0, 0 };
+    assert(w.buffer != NULL);
+    fprintf(file, "#C Saved by lifegame\n");
+    char rule[RULE_LENGTH];
+    formatRule(getRule(), rule, sizeof(rule));
+    fprintf(file, "x = %d, y = %d, rule = %s\n", board.width, board.height, rule);
+
+    long row = 0;
+    for (long i = 0; i < board.height; i++) {
+        const char* cells = &board.data[boardIdx(i, 0, board.width)];
+        long end = board.width;
+        while (end > 0 && !cells[end-1]) {
+            end -= 1;
+        }
+        if (end == 0) {
+            continue;
+        }
+
+        if (i > row) {
+            writeRun(&w, i - row, '$');
+            row = i;
+        }
+        long j = 0;
+        while (j < end) {
+            long k = j;
+            while (k < end && cells[k] == cells[j]) {
+                k += 1;
+            }
+            writeRun(&w, k - j, cells[j] ? 'o' : 'b');
+            j = k;
+        }
+    }
+    flushWriter(&w);
+    fputs("!\n", file);
+    free(w.buffer);
+}
+
+/*
+ * The coordinates are relative to the center of the board
+ */
+static void writeLife106(board_t board, FILE* file) {
+    fprintf(file, "#Life 1.06\n");
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            if (board.data[boardIdx(i, j, board.width)]) {
+                fprintf(file, "%d %d\n", j - board.width / 2, i - board.height / 2);
+            }
+        }
+    }
+}
+
+/*
+ * One row of '0' and '1' written at once, square boards keep the single size
+ */
+static void writeText(board_t board, FILE* file) {
+    char* line = malloc(board.width + 1);
+    assert(line != NULL);
+
+    if (board.width == board.height) {
+        fprintf(file, "%d\n", board.width);
+    } else {
+        fprintf(file, "%d %d\n", board.width, board.height);
+    }
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            line[j] = '0' + board.data[boardIdx(i, j, board.width)];
+        }
+        line[board.width] = '\n';
+        fwrite(line, 1, board.width + 1, file);
+    }
+
+    free(line);
+}
+
+/*
+ * Write a board to a file in the given text format
+ */
+void writePattern(board_t board, FILE* file, int format) {
+    switch (format) {
+        case FORMAT_RLE:
+            writeRLE(board, file);
+            break;
+        case FORMAT_LIFE106:
+            writeLife106(board, file);
+            break;
+        default:
+            writeText(board, file);
+            break;
+    }
+}
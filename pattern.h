@@ -0,0 +1,62 @@
+/*
+ * Title    : Game of life / pattern
+ * Desc     : Headers for the pattern file formats (plain text, RLE, Life 1.06)
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _PATTERN_H_
+#define _PATTERN_H_
+
+#include <stdio.h>
+#include "board.h"
+
+#define FORMAT_TEXT 0
+#define FORMAT_RLE 1
+#define FORMAT_LIFE106 2
+#define FORMAT_BINARY 3
+
+/*
+ * Return the format of a pattern file from its extension (.txt, .rle, .lif, .life, .lgb)
+ * If the extension is unknown, the format is guessed from the first bytes of the
+ * file, header can be NULL to only use the extension
+ */
+int patternFormat(const char* filename, const char* header, int length);
+
+/*
+ * Read a pattern file of any text format into a new board
+ * Board dimensions can be given, 0 to take them from the file
+ * RLE and Life 1.06 patterns are centered on the board, the rule of an RLE
+ * header is selected with setRule
+ */
+board_t readPattern(FILE* file, const char* filename, int* width, int* height);
+
+/*
+ * Write a board to a file in the given text format
+ */
+void writePattern(board_t board, FILE* file, int format);
+
+#endif
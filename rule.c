@@ -0,0 +1,131 @@
+/*
+ * Title    : Game of life / rule
+ * Desc     : Life-like rules in the B/S notation and the rule used by the engines
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "rule.h"
+
+static rule_t currentRule = { RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVAL };
+
+static const struct {
+    rule_t rule;
+    const char* name;
+} ruleNames[] = {
+    { { RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVAL }, "Conway's Life" },
+    { { RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVAL }, "HighLife" },
+    { { RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVAL }, "Day & Night" },
+    { { RULE_SEEDS_BIRTH, RULE_SEEDS_SURVIVAL }, "Seeds" },
+};
+
+/*
+ * Parse a rule : "B36/S23", "b3s23", "S23/B3" or the survival/birth form "23/36"
+ * Return 0 if the rule is invalid or has B0
+ */
+int parseRule(const char* text, rule_t* rule) {
+    rule_t parsed = { 0, 0 };
+    int hasLetters = (strpbrk(text, "BbSs") != NULL);
+    // Without letters, the counts before the slash are the survival ones
+    unsigned* mask = (hasLetters ? NULL : &parsed.survival);
+    int slashes = 0;
+
+    for (const char* c = text; *c; c++) {
+        int upper = toupper((unsigned char)*c);
+        if (upper == 'B' && hasLetters) {
+            mask = &parsed.birth;
+        } else if (upper == 'S' && hasLetters) {
+            mask = &parsed.survival;
+        } else if (*c == '/') {
+            slashes += 1;
+            if (!hasLetters) {
+                mask = &parsed.birth;
+            }
+        } else if (*c >= '0' && *c <= '8' && mask != NULL) {
+            *mask |= 1u << (*c - '0');
+        } else {
+            return 0;
+        }
+    }
+
+    if (slashes > 1 || (!hasLetters && slashes != 1) || (parsed.birth & 1)) {
+        return 0;
+    }
+    *rule = parsed;
+    return 1;
+}
+
+/*
+ * Write a rule in the B/S notation ("B36/S23")
+ */
+void formatRule(rule_t rule, char* buffer, int length) {
+    char text[RULE_LENGTH];
+    int k = 0;
+    text[k++] = 'B';
+    for (int n = 0; n <= 8; n++) {
+        if ((rule.birth >> n) & 1) {
+            text[k++] = '0' + n;
+        }
+    }
+    text[k++] = '/';
+    text[k++] = 'S';
+    for (int n = 0; n <= 8; n++) {
+        if ((rule.survival >> n) & 1) {
+            text[k++] = '0' + n;
+        }
+    }
+    text[k] = '\0';
+    snprintf(buffer, length, "%s", text);
+}
+
+/*
+ * Return the name of a well known rule, NULL for the other ones
+ */
+const char* ruleName(rule_t rule) {
+    for (size_t k = 0; k < sizeof(ruleNames) / sizeof(ruleNames[0]); k++) {
+        if (ruleIs(rule, ruleNames[k].rule.birth, ruleNames[k].rule.survival)) {
+            return ruleNames[k].name;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Select the rule used by every engine, Conway's Life (B3/S23) by default
+ */
+void setRule(rule_t rule) {
+    currentRule = rule;
+}
+
+/*
+ * Return the rule used by every engine
+ */
+rule_t getRule(void) {
+    return currentRule;
+}
@@ -0,0 +1,121 @@
+/*
+ * Title    : Game of life / rule
+ * Desc     : Headers for the Life-like rules (B/S notation)
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _RULE_H_
+#define _RULE_H_
+
+#define RULE_LENGTH 32
+
+/*
+ * A Life-like rule : bit n of birth (survival) is set when a dead (living)
+ * cell with n living neighbours is alive at the next generation
+ * Rules with B0 are not supported, the engines rely on empty space staying empty
+ */
+typedef struct rule {
+    unsigned birth;
+    unsigned survival;
+} rule_t;
+
+#define RULE_CONWAY_BIRTH (1u << 3)
+#define RULE_CONWAY_SURVIVAL ((1u << 2) | (1u << 3))
+#define RULE_HIGHLIFE_BIRTH ((1u << 3) | (1u << 6))
+#define RULE_HIGHLIFE_SURVIVAL RULE_CONWAY_SURVIVAL
+#define RULE_DAYNIGHT_BIRTH ((1u << 3) | (1u << 6) | (1u << 7) | (1u << 8))
+#define RULE_DAYNIGHT_SURVIVAL ((1u << 3) | (1u << 4) | (1u << 6) | (1u << 7) | (1u << 8))
+#define RULE_SEEDS_BIRTH (1u << 2)
+#define RULE_SEEDS_SURVIVAL 0u
+
+/*
+ * Return 1 if the rule has the given masks
+ */
+static inline int ruleIs(rule_t rule, unsigned birth, unsigned survival) {
+    return rule.birth == birth && rule.survival == survival;
+}
+
+/*
+ * Next state of a cell with sum living neighbours
+ * With constant masks the test is resolved at compile time
+ */
+static inline int ruleNext(int cell, int sum, unsigned birth, unsigned survival) {
+    if (birth == RULE_CONWAY_BIRTH && survival == RULE_CONWAY_SURVIVAL) {
+        // sum | cell is 3 only for sum == 3, or sum == 2 with a living cell
+        return (sum | cell) == 3;
+    }
+    // Branchless like the SIMD kernels : bit sum + 9 * cell of both masks
+    return ((birth | survival << 9) >> (sum + 9*cell)) & 1;
+}
+
+/*
+ * Expand CALL(birth, survival) with constant masks for the common rules (Conway,
+ * HighLife, Day & Night, Seeds), so the inlined kernels are specialized at
+ * compile time, and with the masks of the rule for the other ones
+ */
+#define RULE_SPECIALIZE(rule, CALL) \
+    do { \
+        if (ruleIs((rule), RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVAL)) { \
+            CALL(RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVAL); \
+        } else if (ruleIs((rule), RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVAL)) { \
+            CALL(RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVAL); \
+        } else if (ruleIs((rule), RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVAL)) { \
+            CALL(RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVAL); \
+        } else if (ruleIs((rule), RULE_SEEDS_BIRTH, RULE_SEEDS_SURVIVAL)) { \
+            CALL(RULE_SEEDS_BIRTH, RULE_SEEDS_SURVIVAL); \
+        } else { \
+            CALL((rule).birth, (rule).survival); \
+        } \
+    } while (0)
+
+/*
+ * Parse a rule : "B36/S23", "b3s23", "S23/B3" or the survival/birth form "23/36"
+ * Return 0 if the rule is invalid or has B0
+ */
+int parseRule(const char* text, rule_t* rule);
+
+/*
+ * Write a rule in the B/S notation ("B36/S23")
+ */
+void formatRule(rule_t rule, char* buffer, int length);
+
+/*
+ * Return the name of a well known rule, NULL for the other ones
+ */
+const char* ruleName(rule_t rule);
+
+/*
+ * Select the rule used by every engine, Conway's Life (B3/S23) by default
+ */
+void setRule(rule_t rule);
+
+/*
+ * Return the rule used by every engine
+ */
+rule_t getRule(void);
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Title    : Game of life / simd
+ * Desc     : Vectorized Game of Life kernels (SSE2, AVX2, AVX-512)
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include "board.h"
+#include "simd.h"
+#include "rule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86 1
+#else
+#define HAS_X86 0
+#endif
+
+/*
+ * Next state of the cell j of a row, the halo gives its neighbours at the edges
+ * Used for the last cells of a row that don't fill a vector
+ */
+static inline char lifeCell(const char* up, const char* mid, const char* down, int j, rule_t rule) {
+    int sum = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + down[j-1] + down[j] + down[j+1];
+    return ruleNext(mid[j], sum, rule.birth, rule.survival);
+}
+
+/*
+ * Generate a row kernel from the vector type and its intrinsics
+ * The 8 neighbours are loaded unaligned around column j, the halo of the board
+ * giving the ones outside of it. The cells being 0 or 1, a byte addition can't
+ * overflow. For Conway's rule (sum | cell) == 3 gives the new state, other
+ * rules compare the key sum + 9 * cell (0 to 17) to each count of their birth
+ * (sum) and survival (9 + sum) masks. The XOR of the cells before and after
+ * is kept with them, ANY of it gives each changed tile of the row
+ */
+#define SIMD_ROW(NAME, TARGET, WIDTH, VEC, LOAD, STORE, SET1, ADD, OR, XOR, ANY, LIFE) \
+__attribute__((target(TARGET))) \
+static void NAME(board_t state, board_t newState, int i, rule_t rule, changes_t* changes) { \
+    int width = state.width; \
+    const char* up = &state.data[boardIdx(i-1, 0, width)]; \
+    const char* mid = &state.data[boardIdx(i, 0, width)]; \
+    const char* down = &state.data[boardIdx(i+1, 0, width)]; \
+    char* out = &newState.data[boardIdx(i, 0, width)]; \
+    const VEC one = SET1(1); \
+    const VEC three = SET1(3); \
+    unsigned keys = rule.birth | (rule.survival << 9); \
+    int conway = ruleIs(rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVAL); \
+    uint64_t* changed = (changes != NULL ? changedRow(changes, i) : NULL); \
+    if (changed != NULL) { \
+        memset(changed, 0, changes->masks * sizeof(uint64_t)); \
+    } \
+    VEC diff = SET1(0); \
+    \
+    int j = 0; \
+    if (conway) { \
+        for (; j + WIDTH <= width; j += WIDTH) { \
+            VEC sum = ADD(ADD(ADD(LOAD(up+j-1), LOAD(up+j)), ADD(LOAD(up+j+1), LOAD(mid+j-1))), \
+                          ADD(ADD(LOAD(mid+j+1), LOAD(down+j-1)), ADD(LOAD(down+j), LOAD(down+j+1)))); \
+            VEC cell = LOAD(mid+j); \
+            VEC next = LIFE(OR(sum, cell), three); \
+            STORE(out+j, next); \
+            diff = OR(diff, XOR(next, cell)); \
+            if (changed != NULL && (j + WIDTH) % CHANGE_TILE == 0) { \
+                changed[j / (64 * CHANGE_TILE)] |= (uint64_t)(ANY(diff) != 0) << ((j / CHANGE_TILE) % 64); \
+                diff = SET1(0); \
+            } \
+        } \
+    } \
+    for (; j + WIDTH <= width; j += WIDTH) { \
+        VEC sum = ADD(ADD(ADD(LOAD(up+j-1), LOAD(up+j)), ADD(LOAD(up+j+1), LOAD(mid+j-1))), \
+                      ADD(ADD(LOAD(mid+j+1), LOAD(down+j-1)), ADD(LOAD(down+j), LOAD(down+j+1)))); \
+        VEC cell = LOAD(mid+j); \
+        VEC cell2 = ADD(cell, cell); \
+        VEC cell8 = ADD(ADD(cell2, cell2), ADD(cell2, cell2)); \
+        VEC key = ADD(sum, ADD(cell8, cell)); \
+        VEC next = SET1(0); \
+        for (int k = 0; k < 18; k++) { \
+            if ((keys >> k) & 1) { \
+                next = OR(next, LIFE(key, SET1(k))); \
+            } \
+        } \
+        STORE(out+j, next); \
+        diff = OR(diff, XOR(next, cell)); \
+        if (changed != NULL && (j + WIDTH) % CHANGE_TILE == 0) { \
+            changed[j / (64 * CHANGE_TILE)] |= (uint64_t)(ANY(diff) != 0) << ((j / CHANGE_TILE) % 64); \
+            diff = SET1(0); \
+        } \
+    } \
+    for (; j < width; j++) { \
+        out[j] = lifeCell(up, mid, down, j, rule); \
+    } \
+    if (changed != NULL) { \
+        /* The last tile, not filled by the vectors */ \
+        int last = width / CHANGE_TILE * CHANGE_TILE; \
+        changed[last / (64 * CHANGE_TILE)] |= changedCells(mid, out, last, width); \
+    } \
+}
+
+/*
+ * Generate a full board kernel calling the row kernel on every row, each row
+ * writes its own changed tiles
+ */
+#define SIMD_KERNEL(NAME, ROW) \
+void NAME(board_t state, board_t newState, changes_t* changes) { \
+    int height = state.height; \
+    rule_t rule = getRule(); \
+    \
+    _Pragma("omp parallel for") \
+    for (int i = 0; i < height; i++) { \
+        ROW(state, newState, i, rule, changes); \
+    } \
+}
+
+#if HAS_X86
+
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define SSE2_STORE(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define SSE2_LIFE(v, k) _mm_and_si128(_mm_cmpeq_epi8((v), (k)), one)
+
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), (v))
+#define AVX2_LIFE(v, k) _mm256_and_si256(_mm256_cmpeq_epi8((v), (k)), one)
+
+#define AVX512_LOAD(p) _mm512_loadu_si512((const void*)(p))
+#define AVX512_STORE(p, v) _mm512_storeu_si512((void*)(p), (v))
+#define AVX512_LIFE(v, k) _mm512_maskz_mov_epi8(_mm512_cmpeq_epi8_mask((v), (k)), one)
+
+#define SSE2_ANY(v) (_mm_movemask_epi8(_mm_cmpeq_epi8((v), _mm_setzero_si128())) != 0xFFFF)
+#define AVX2_ANY(v) (!_mm256_testz_si256((v), (v)))
+#define AVX512_ANY(v) _mm512_test_epi8_mask((v), (v))
+
+SIMD_ROW(rowSSE2, "sse2", 16, __m128i, SSE2_LOAD, SSE2_STORE, _mm_set1_epi8,
+         _mm_add_epi8, _mm_or_si128, _mm_xor_si128, SSE2_ANY, SSE2_LIFE)
+SIMD_ROW(rowAVX2, "avx2", 32, __m256i, AVX2_LOAD, AVX2_STORE, _mm256_set1_epi8,
+         _mm256_add_epi8, _mm256_or_si256, _mm256_xor_si256, AVX2_ANY, AVX2_LIFE)
+SIMD_ROW(rowAVX512, "avx512f,avx512bw", 64, __m512i, AVX512_LOAD, AVX512_STORE, _mm512_set1_epi8,
+         _mm512_add_epi8, _mm512_or_si512, _mm512_xor_si512, AVX512_ANY, AVX512_LIFE)
+
+SIMD_KERNEL(calculateStateSSE2, rowSSE2)
+SIMD_KERNEL(calculateStateAVX2, rowAVX2)
+SIMD_KERNEL(calculateStateAVX512, rowAVX512)
+
+int sse2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+int avx2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+int avx512Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+#else
+
+/*
+ * Without x86 intrinsics the kernels are never selected, fall back on scalar rows
+ */
+#define SCALAR_ROW(NAME) \
+static void NAME(board_t state, board_t newState, int i, rule_t rule, changes_t* changes) { \
+    const char* up = &state.data[boardIdx(i-1, 0, state.width)]; \
+    const char* mid = &state.data[boardIdx(i, 0, state.width)]; \
+    const char* down = &state.data[boardIdx(i+1, 0, state.width)]; \
+    for (int j = 0; j < state.width; j++) { \
+        newState.data[boardIdx(i, j, state.width)] = lifeCell(up, mid, down, j, rule); \
+    } \
+    if (changes != NULL) { \
+        markCharRow(changes, i, mid, &newState.data[boardIdx(i, 0, state.width)], state.width); \
+    } \
+}
+
+SCALAR_ROW(rowScalar)
+SIMD_KERNEL(calculateStateSSE2, rowScalar)
+SIMD_KERNEL(calculateStateAVX2, rowScalar)
+SIMD_KERNEL(calculateStateAVX512, rowScalar)
+
+int sse2Supported() { return 0; }
+int avx2Supported() { return 0; }
+int avx512Supported() { return 0; }
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Title    : Game of life / simd
+ * Desc     : Headers for the vectorized Game of Life kernels
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include "board.h"
+
+/**
+ * Return 1 if the host CPU can run the kernel (checked with cpuid)
+ */
+int sse2Supported();
+int avx2Supported();
+int avx512Supported();
+
+/**
+ * Calculate the next state with 16 cells per instruction
+ */
+void calculateStateSSE2(board_t state, board_t newState, changes_t* changes);
+/**
+ * Calculate the next state with 32 cells per instruction
+ */
+void calculateStateAVX2(board_t state, board_t newState, changes_t* changes);
+/**
+ * Calculate the next state with 64 cells per instruction
+ */
+void calculateStateAVX512(board_t state, board_t newState, changes_t* changes);
+
+#endif
@@ -0,0 +1,271 @@
+/*
+ * Title    : Game of life / snapshot
+ * Desc     : Asynchronous snapshots, boards written by a background thread
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "board.h"
+#include "pattern.h"
+#include "binary.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_NAME 256
+
+/*
+ * A single copy buffer : a new snapshot waits until the previous one is written
+ * Only one of board and packed is used by a snapshot
+ */
+struct snapshot {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;
+    int quit;
+
+    board_t board;
+    packed_board_t packed;
+    int isPacked;
+    long long generation;
+    char filename[SNAPSHOT_NAME];
+
+    int count;
+    double writeTime;
+};
+
+/*
+ * Return the time in ms
+ */
+static double now(void) {
+    struct timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec*1e+3 + t.tv_usec*1e-3;
+}
+
+/*
+ * Write the copy to a temporary file, renamed once complete so an
+ * interrupted write never replaces the previous snapshot
+ */
+static void writeSnapshot(snapshot_t* snap) {
+    char tmp[SNAPSHOT_NAME + 8];
+    snprintf(tmp, sizeof(tmp), "%s.part", snap->filename);
+    int format = patternFormat(snap->filename, NULL, 0);
+
+    if (format == FORMAT_BINARY) {
+        if (snap->isPacked) {
+            writeBinaryBoard(snap->packed, snap->generation, tmp);
+        } else {
+            packed_board_t packed = allocPackedBoard(snap->board.width, snap->board.height);
+            packBoard(snap->board, packed);
+            writeBinaryBoard(packed, snap->generation, tmp);
+            freePackedBoard(packed);
+        }
+    } else {
+        board_t board = snap->board;
+        if (snap->isPacked) {
+            board = allocBoard(snap->packed.width, snap->packed.height);
+            unpackBoard(snap->packed, board);
+        }
+        FILE* file = fopen(tmp, "wb");
+        assert(file != NULL);
+        writePattern(board, file, format);
+        fclose(file);
+        if (snap->isPacked) {
+            freeBoard(board);
+        }
+    }
+
+    if (rename(tmp, snap->filename) != 0) {
+        perror(snap->filename);
+    }
+}
+
+/*
+ * Writer thread, waits for a pending snapshot and writes it
+ */
+static void* writerLoop(void* arg) {
+    snapshot_t* snap = arg;
+
+    pthread_mutex_lock(&snap->lock);
+    while (1) {
+        while (!snap->pending && !snap->quit) {
+            pthread_cond_wait(&snap->cond, &snap->lock);
+        }
+        if (!snap->pending) {
+            break;
+        }
+        pthread_mutex_unlock(&snap->lock);
+
+        // The copy belongs to the writer until pending is cleared
+        double begin = now();
+        writeSnapshot(snap);
+        double dur = now() - begin;
+
+        pthread_mutex_lock(&snap->lock);
+        snap->count += 1;
+        snap->writeTime += dur;
+        snap->pending = 0;
+        pthread_cond_broadcast(&snap->cond);
+    }
+    pthread_mutex_unlock(&snap->lock);
+
+    return NULL;
+}
+
+/*
+ * Start the writer thread
+ */
+snapshot_t* snapshotCreate(void) {
+    snapshot_t* snap = calloc(1, sizeof(snapshot_t));
+    assert(snap != NULL);
+
+    pthread_mutex_init(&snap->lock, NULL);
+    pthread_cond_init(&snap->cond, NULL);
+    int err = pthread_create(&snap->thread, NULL, writerLoop, snap);
+    assert(err == 0);
+
+    return snap;
+}
+
+/*
+ * Wait until every snapshot is written
+ */
+void snapshotWait(snapshot_t* snap) {
+    pthread_mutex_lock(&snap->lock);
+    while (snap->pending) {
+        pthread_cond_wait(&snap->cond, &snap->lock);
+    }
+    pthread_mutex_unlock(&snap->lock);
+}
+
+/*
+ * Wait for the last snapshot to be written, then stop the writer thread
+ */
+void snapshotFree(snapshot_t* snap) {
+    pthread_mutex_lock(&snap->lock);
+    snap->quit = 1;
+    pthread_cond_broadcast(&snap->cond);
+    pthread_mutex_unlock(&snap->lock);
+    pthread_join(snap->thread, NULL);
+
+    pthread_mutex_destroy(&snap->lock);
+    pthread_cond_destroy(&snap->cond);
+    freeBoard(snap->board);
+    if (snap->packed.data != NULL) {
+        freePackedBoard(snap->packed);
+    }
+    free(snap);
+}
+
+/*
+ * Wait for the copy buffer, then fill the parameters common to both kinds of boards
+ */
+static void beginSnapshot(snapshot_t* snap, int isPacked, long long generation, const char* filename) {
+    pthread_mutex_lock(&snap->lock);
+    while (snap->pending) {
+        pthread_cond_wait(&snap->cond, &snap->lock);
+    }
+    pthread_mutex_unlock(&snap->lock);
+
+    snap->isPacked = isPacked;
+    snap->generation = generation;
+    snprintf(snap->filename, SNAPSHOT_NAME, "%s", filename);
+}
+
+/*
+ * Hand the copy over to the writer thread
+ */
+static void endSnapshot(snapshot_t* snap) {
+    pthread_mutex_lock(&snap->lock);
+    snap->pending = 1;
+    pthread_cond_broadcast(&snap->cond);
+    pthread_mutex_unlock(&snap->lock);
+}
+
+/*
+ * Copy a board to be saved in the background, the format is given by the extension
+ * Return the stall in ms : waiting for the previous snapshot plus the copy
+ */
+double snapshotBoard(snapshot_t* snap, board_t board, long long generation, const char* filename) {
+    double begin = now();
+    beginSnapshot(snap, 0, generation, filename);
+
+    if (snap->board.width != board.width || snap->board.height != board.height) {
+        freeBoard(snap->board);
+        snap->board = allocBoard(board.width, board.height);
+    }
+    copyBoard(board, snap->board);
+
+    endSnapshot(snap);
+    return now() - begin;
+}
+
+/*
+ * Same as snapshotBoard for a bit-packed board
+ */
+double snapshotPacked(snapshot_t* snap, packed_board_t board, long long generation, const char* filename) {
+    double begin = now();
+    beginSnapshot(snap, 1, generation, filename);
+
+    if (snap->packed.data == NULL || snap->packed.width != board.width || snap->packed.height != board.height) {
+        if (snap->packed.data != NULL) {
+            freePackedBoard(snap->packed);
+        }
+        snap->packed = allocPackedBoard(board.width, board.height);
+    }
+    memcpy(snap->packed.data, board.data, (size_t)(board.height + 2) * board.words * sizeof(uint64_t));
+
+    endSnapshot(snap);
+    return now() - begin;
+}
+
+/*
+ * Number of snapshots written
+ */
+int snapshotCount(snapshot_t* snap) {
+    pthread_mutex_lock(&snap->lock);
+    int count = snap->count;
+    pthread_mutex_unlock(&snap->lock);
+    return count;
+}
+
+/*
+ * Total time spent writing the snapshots in ms
+ */
+double snapshotWriteTime(snapshot_t* snap) {
+    pthread_mutex_lock(&snap->lock);
+    double writeTime = snap->writeTime;
+    pthread_mutex_unlock(&snap->lock);
+    return writeTime;
+}
@@ -0,0 +1,78 @@
+/*
+ * Title    : Game of life / snapshot
+ * Desc     : Headers for the asynchronous snapshots
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include "board.h"
+
+/*
+ * Background writer of board snapshots
+ * The board is copied, then written by a thread while the game goes on
+ */
+typedef struct snapshot snapshot_t;
+
+/*
+ * Start the writer thread
+ */
+snapshot_t* snapshotCreate(void);
+
+/*
+ * Wait for the last snapshot to be written, then stop the writer thread
+ */
+void snapshotFree(snapshot_t* snap);
+
+/*
+ * Copy a board to be saved in the background, the format is given by the extension
+ * Return the stall in ms : waiting for the previous snapshot plus the copy
+ */
+double snapshotBoard(snapshot_t* snap, board_t board, long long generation, const char* filename);
+
+/*
+ * Same as snapshotBoard for a bit-packed board
+ */
+double snapshotPacked(snapshot_t* snap, packed_board_t board, long long generation, const char* filename);
+
+/*
+ * Wait until every snapshot is written
+ */
+void snapshotWait(snapshot_t* snap);
+
+/*
+ * Number of snapshots written
+ */
+int snapshotCount(snapshot_t* snap);
+
+/*
+ * Total time spent writing the snapshots in ms
+ */
+double snapshotWriteTime(snapshot_t* snap);
+
+#endif
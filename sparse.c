@@ -0,0 +1,432 @@
+/*
+ * Title    : Game of life / sparse
+ * Desc     : Sparse engine, hashed chunks on an unbounded plane
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "automata.h"
+#include "sparse.h"
+#include "rule.h"
+#include "math.h"
+
+#define MIN_TABLE_SIZE 1024
+
+/*
+ * cells holds two generations, cells[parity] being the current one
+ * Row r is cells[.][r], the column c is the bit c of the row
+ */
+struct chunk {
+    int64_t ci;
+    int64_t cj;
+    uint64_t cells[2][CHUNK_SIZE];
+    uint64_t population;
+    size_t index;
+    chunk_t* next;
+};
+
+struct sparse {
+    chunk_t** table;
+    size_t tableSize;
+    chunk_t** chunks;
+    size_t count;
+    size_t capacity;
+    int parity;
+};
+
+/*
+ * Hash of the chunk coordinates
+ */
+static inline size_t hashCoords(int64_t ci, int64_t cj) {
+    uint64_t h = (uint64_t)ci * 0x9E3779B97F4A7C15ull ^ (uint64_t)cj * 0xC2B2AE3D27D4EB4Full;
+    return h ^ (h >> 29);
+}
+
+/*
+ * Return the chunk at the given chunk coordinates, NULL if it's not allocated
+ */
+static chunk_t* findChunk(sparse_t* universe, int64_t ci, int64_t cj) {
+    size_t h = hashCoords(ci, cj) & (universe->tableSize - 1);
+    for (chunk_t* c = universe->table[h]; c != NULL; c = c->next) {
+        if (c->ci == ci && c->cj == cj) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Double the hash table size and rehash all the chunks
+ */
+static void growTable(sparse_t* universe) {
+    size_t newSize = universe->tableSize * 2;
+    chunk_t** table = calloc(sizeof(chunk_t*), newSize);
+    assert(table != NULL);
+
+    for (size_t k = 0; k < universe->count; k++) {
+        chunk_t* c = universe->chunks[k];
+        size_t h = hashCoords(c->ci, c->cj) & (newSize - 1);
+        c->next = table[h];
+        table[h] = c;
+    }
+
+    free(universe->table);
+    universe->table = table;
+    universe->tableSize = newSize;
+}
+
+/*
+ * Return the chunk at the given chunk coordinates, allocating an empty one if needed
+ */
+static chunk_t* getChunk(sparse_t* universe, int64_t ci, int64_t cj) {
+    chunk_t* c = findChunk(universe, ci, cj);
+    if (c != NULL) {
+        return c;
+    }
+
+    c = calloc(sizeof(chunk_t), 1);
+    assert(c != NULL);
+    c->ci = ci;
+    c->cj = cj;
+
+    if (universe->count == universe->capacity) {
+        universe->capacity = (universe->capacity == 0 ? 64 : universe->capacity * 2);
+        universe->chunks = realloc(universe->chunks, sizeof(chunk_t*) * universe->capacity);
+        assert(universe->chunks != NULL);
+    }
+    c->index = universe->count;
+    universe->chunks[universe->count++] = c;
+
+    if (universe->count > universe->tableSize * 3 / 4) {
+        growTable(universe);
+    } else {
+        size_t h = hashCoords(ci, cj) & (universe->tableSize - 1);
+        c->next = universe->table[h];
+        universe->table[h] = c;
+    }
+
+    return c;
+}
+
+/*
+ * Unlink a chunk from the table and the list, then free it
+ */
+static void removeChunk(sparse_t* universe, chunk_t* c) {
+    chunk_t** link = &universe->table[hashCoords(c->ci, c->cj) & (universe->tableSize - 1)];
+    while (*link != c) {
+        link = &(*link)->next;
+    }
+    *link = c->next;
+
+    chunk_t* last = universe->chunks[--universe->count];
+    universe->chunks[c->index] = last;
+    last->index = c->index;
+    free(c);
+}
+
+/*
+ * Free all the chunks
+ */
+static void clearChunks(sparse_t* universe) {
+    for (size_t k = 0; k < universe->count; k++) {
+        free(universe->chunks[k]);
+    }
+    memset(universe->table, 0, sizeof(chunk_t*) * universe->tableSize);
+    universe->count = 0;
+}
+
+/*
+ * Return the current row r of a chunk, 0 if the chunk doesn't exist
+ */
+static inline uint64_t chunkRow(chunk_t* c, int parity, int r) {
+    return (c != NULL ? c->cells[parity][r] : 0);
+}
+
+/*
+ * Allocate the neighbour chunks where a living border cell can give birth
+ */
+static void growChunk(sparse_t* universe, chunk_t* c) {
+    int p = universe->parity;
+    uint64_t top = c->cells[p][0];
+    uint64_t bottom = c->cells[p][CHUNK_SIZE-1];
+    uint64_t left = 0, right = 0;
+    for (int r = 0; r < CHUNK_SIZE; r++) {
+        left |= c->cells[p][r] & 1;
+        right |= c->cells[p][r] >> (CHUNK_SIZE-1);
+    }
+
+    if (top) getChunk(universe, c->ci-1, c->cj);
+    if (bottom) getChunk(universe, c->ci+1, c->cj);
+    if (left) getChunk(universe, c->ci, c->cj-1);
+    if (right) getChunk(universe, c->ci, c->cj+1);
+    if (top & 1) getChunk(universe, c->ci-1, c->cj-1);
+    if (top >> (CHUNK_SIZE-1)) getChunk(universe, c->ci-1, c->cj+1);
+    if (bottom & 1) getChunk(universe, c->ci+1, c->cj-1);
+    if (bottom >> (CHUNK_SIZE-1)) getChunk(universe, c->ci+1, c->cj+1);
+}
+
+/*
+ * Next state of the rows of a chunk from their west, centre and east words
+ * Return the population of the new rows
+ */
+static inline uint64_t stepRows(const uint64_t* w, const uint64_t* m, const uint64_t* e, uint64_t* out,
+                                unsigned birth, unsigned survival) {
+    uint64_t population = 0;
+    for (int r = 0; r < CHUNK_SIZE; r++) {
+        uint64_t word = lifeWordRule(w[r], m[r], e[r], w[r+1], m[r+1], e[r+1], w[r+2], m[r+2], e[r+2],
+                                     birth, survival);
+        out[r] = word;
+        population += __builtin_popcountll(word);
+    }
+    return population;
+}
+
+/*
+ * Calculate the next state of a chunk from its current state and its 8 neighbours
+ */
+static void stepChunk(sparse_t* universe, chunk_t* c) {
+    int p = universe->parity;
+    chunk_t* nb[3][3];
+    for (int di = -1; di <= 1; di++) {
+        for (int dj = -1; dj <= 1; dj++) {
+            nb[di+1][dj+1] = (di == 0 && dj == 0 ? c : findChunk(universe, c->ci+di, c->cj+dj));
+        }
+    }
+
+    // West, centre and east words of the rows -1 to 64
+    uint64_t w[CHUNK_SIZE+2], m[CHUNK_SIZE+2], e[CHUNK_SIZE+2];
+    for (int r = -1; r <= CHUNK_SIZE; r++) {
+        int band = (r < 0 ? 0 : (r < CHUNK_SIZE ? 1 : 2));
+        int row = (r + CHUNK_SIZE) % CHUNK_SIZE;
+        uint64_t centre = chunkRow(nb[band][1], p, row);
+        m[r+1] = centre;
+        w[r+1] = (centre << 1) | (chunkRow(nb[band][0], p, row) >> (CHUNK_SIZE-1));
+        e[r+1] = (centre >> 1) | (chunkRow(nb[band][2], p, row) << (CHUNK_SIZE-1));
+    }
+
+    #define CHUNK_ROWS(B, S) c->population = stepRows(w, m, e, c->cells[!p], B, S)
+    RULE_SPECIALIZE(getRule(), CHUNK_ROWS);
+    #undef CHUNK_ROWS
+}
+
+/**
+ * Create a sparse universe containing the board
+ * The universe is unbounded, the board is only a window on it
+ */
+sparse_t* sparseCreate(board_t board) {
+    sparse_t* universe = calloc(sizeof(sparse_t), 1);
+    assert(universe != NULL);
+
+    universe->tableSize = MIN_TABLE_SIZE;
+    universe->table = calloc(sizeof(chunk_t*), universe->tableSize);
+    assert(universe->table != NULL);
+
+    sparseLoad(universe, board);
+    return universe;
+}
+
+/**
+ * Free the universe and all its chunks
+ */
+void sparseFree(sparse_t* universe) {
+    clearChunks(universe);
+    free(universe->chunks);
+    free(universe->table);
+    free(universe);
+}
+
+/**
+ * Replace the universe content with the board
+ */
+void sparseLoad(sparse_t* universe, board_t board) {
+    clearChunks(universe);
+
+    for (int i = 0; i < board.height; i++) {
+        for (int j = 0; j < board.width; j++) {
+            if (board.data[boardIdx(i, j, board.width)]) {
+                chunk_t* c = getChunk(universe, i / CHUNK_SIZE, j / CHUNK_SIZE);
+                c->cells[universe->parity][i % CHUNK_SIZE] |= (uint64_t)1 << (j % CHUNK_SIZE);
+                c->population += 1;
+            }
+        }
+    }
+}
+
+/**
+ * Write the cells visible in the board window
+ */
+void sparseStore(sparse_t* universe, board_t board) {
+    sparseStoreAt(universe, board, 0, 0);
+}
+
+/**
+ * Write the cells visible in a board window whose cell (0, 0) is the cell
+ * (i0, j0) of the universe
+ */
+void sparseStoreAt(sparse_t* universe, board_t board, int64_t i0, int64_t j0) {
+    clearBoard(board);
+
+    for (size_t k = 0; k < universe->count; k++) {
+        chunk_t* c = universe->chunks[k];
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            int64_t i = c->ci * CHUNK_SIZE + r - i0;
+            uint64_t word = c->cells[universe->parity][r];
+            for (int b = 0; word != 0 && b < CHUNK_SIZE; b++, word >>= 1) {
+                int64_t j = c->cj * CHUNK_SIZE + b - j0;
+                if ((word & 1) && i >= 0 && i < board.height && j >= 0 && j < board.width) {
+                    board.data[boardIdx(i, j, board.width)] = 1;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Write the bounding box of the living cells (first and last rows and columns)
+ * Return 0 if the universe is empty
+ */
+int sparseBounds(sparse_t* universe, int64_t* i0, int64_t* j0, int64_t* i1, int64_t* j1) {
+    int64_t top = INT64_MAX, left = INT64_MAX, bottom = INT64_MIN, right = INT64_MIN;
+    for (size_t k = 0; k < universe->count; k++) {
+        chunk_t* c = universe->chunks[k];
+        uint64_t columns = 0;
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            uint64_t word = c->cells[universe->parity][r];
+            if (word != 0) {
+                top = min(top, c->ci * CHUNK_SIZE + r);
+                bottom = max(bottom, c->ci * CHUNK_SIZE + r);
+                columns |= word;
+            }
+        }
+        if (columns != 0) {
+            int64_t first = c->cj * CHUNK_SIZE + __builtin_ctzll(columns);
+            int64_t last = c->cj * CHUNK_SIZE + (CHUNK_SIZE - 1 - __builtin_clzll(columns));
+            left = min(left, first);
+            right = max(right, last);
+        }
+    }
+    *i0 = top;
+    *j0 = left;
+    *i1 = bottom;
+    *j1 = right;
+    return bottom >= top;
+}
+
+/**
+ * Kill the cell (i, j) of the universe
+ */
+void sparseKill(sparse_t* universe, int64_t i, int64_t j) {
+    int64_t ci = (i >= 0 ? i : i - CHUNK_SIZE + 1) / CHUNK_SIZE;
+    int64_t cj = (j >= 0 ? j : j - CHUNK_SIZE + 1) / CHUNK_SIZE;
+    chunk_t* c = findChunk(universe, ci, cj);
+    uint64_t bit = (uint64_t)1 << (j - cj * CHUNK_SIZE);
+    if (c != NULL && (c->cells[universe->parity][i - ci * CHUNK_SIZE] & bit)) {
+        c->cells[universe->parity][i - ci * CHUNK_SIZE] &= ~bit;
+        c->population -= 1;
+    }
+}
+
+/**
+ * Replace the universe dst content with the one of src
+ */
+void sparseCopy(sparse_t* dst, sparse_t* src) {
+    clearChunks(dst);
+    for (size_t k = 0; k < src->count; k++) {
+        chunk_t* c = src->chunks[k];
+        chunk_t* copy = getChunk(dst, c->ci, c->cj);
+        memcpy(copy->cells[dst->parity], c->cells[src->parity], sizeof(copy->cells[0]));
+        copy->population = c->population;
+    }
+}
+
+/**
+ * Return 1 if both universes have the same living cells
+ */
+int sparseEqual(sparse_t* a, sparse_t* b) {
+    if (sparsePopulation(a) != sparsePopulation(b)) {
+        return 0;
+    }
+    // Same population : the cells of a found in b are all the cells of b
+    for (size_t k = 0; k < a->count; k++) {
+        chunk_t* c = a->chunks[k];
+        if (c->population == 0) {
+            continue;
+        }
+        chunk_t* other = findChunk(b, c->ci, c->cj);
+        if (other == NULL || memcmp(c->cells[a->parity], other->cells[b->parity], sizeof(c->cells[0]))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Calculate the next state of the universe
+ * Chunks are created next to living border cells and freed when they become empty
+ */
+void calculateStateSparse(sparse_t* universe) {
+    size_t occupied = universe->count;
+    for (size_t k = 0; k < occupied; k++) {
+        growChunk(universe, universe->chunks[k]);
+    }
+
+    // A few chunks are stepped by the calling thread, e.g. a worker of the census
+    #pragma omp parallel for schedule(dynamic, 64) if (universe->count > SPARSE_PARALLEL_CHUNKS)
+    for (size_t k = 0; k < universe->count; k++) {
+        stepChunk(universe, universe->chunks[k]);
+    }
+    universe->parity = !universe->parity;
+
+    // Backwards, so the chunk moved into a freed slot was already checked
+    for (size_t k = universe->count; k > 0; k--) {
+        chunk_t* c = universe->chunks[k-1];
+        if (c->population == 0) {
+            removeChunk(universe, c);
+        }
+    }
+}
+
+/**
+ * Return the number of living cells in the whole universe
+ */
+uint64_t sparsePopulation(sparse_t* universe) {
+    uint64_t population = 0;
+    for (size_t k = 0; k < universe->count; k++) {
+        population += universe->chunks[k]->population;
+    }
+    return population;
+}
+
+/**
+ * Return the number of allocated chunks
+ */
+size_t sparseChunks(sparse_t* universe) {
+    return universe->count;
+}
@@ -0,0 +1,103 @@
+/*
+ * Title    : Game of life / sparse
+ * Desc     : Headers for the sparse engine on an unbounded plane
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+
+/*
+ * A chunk is a bit-packed square of 64x64 cells, only occupied chunks are allocated
+ */
+#define CHUNK_SIZE 64
+/*
+ * Smallest number of chunks stepped by several threads
+ */
+#define SPARSE_PARALLEL_CHUNKS 16
+
+typedef struct chunk chunk_t;
+typedef struct sparse sparse_t;
+
+/**
+ * Create a sparse universe containing the board
+ * The universe is unbounded, the board is only a window on it
+ */
+sparse_t* sparseCreate(board_t board);
+/**
+ * Free the universe and all its chunks
+ */
+void sparseFree(sparse_t* universe);
+/**
+ * Replace the universe content with the board
+ */
+void sparseLoad(sparse_t* universe, board_t board);
+/**
+ * Write the cells visible in the board window
+ */
+void sparseStore(sparse_t* universe, board_t board);
+/**
+ * Write the cells visible in a board window whose cell (0, 0) is the cell
+ * (i0, j0) of the universe
+ */
+void sparseStoreAt(sparse_t* universe, board_t board, int64_t i0, int64_t j0);
+/**
+ * Write the bounding box of the living cells (first and last rows and columns)
+ * Return 0 if the universe is empty
+ */
+int sparseBounds(sparse_t* universe, int64_t* i0, int64_t* j0, int64_t* i1, int64_t* j1);
+/**
+ * Kill the cell (i, j) of the universe
+ */
+void sparseKill(sparse_t* universe, int64_t i, int64_t j);
+/**
+ * Replace the universe dst content with the one of src
+ */
+void sparseCopy(sparse_t* dst, sparse_t* src);
+/**
+ * Return 1 if both universes have the same living cells
+ */
+int sparseEqual(sparse_t* a, sparse_t* b);
+/**
+ * Calculate the next state of the universe
+ * Chunks are created next to living border cells and freed when they become empty
+ */
+void calculateStateSparse(sparse_t* universe);
+/**
+ * Return the number of living cells in the whole universe
+ */
+uint64_t sparsePopulation(sparse_t* universe);
+/**
+ * Return the number of allocated chunks
+ */
+size_t sparseChunks(sparse_t* universe);
+
+#endif
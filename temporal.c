@@ -0,0 +1,172 @@
+/*
+ * Title    : Game of life / temporal
+ * Desc     : Temporally blocked engine, several generations per memory pass
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "board.h"
+#include "automata.h"
+#include "rule.h"
+#include "temporal.h"
+
+/*
+ * Load a tile and its halo in the scratch, the cells outside of the board are dead
+ * Scratch row r is the board row i0-T+r, scratch word c is the board word k0-1+c
+ * Rows outside of the board are never computed, they are cleared in both buffers
+ */
+static void loadTile(packed_board_t state, uint64_t* scratch, uint64_t* other,
+                     int i0, int k0, int height, int width, int T) {
+    for (int r = 0; r < height; r++) {
+        int i = i0 - T + r;
+        uint64_t* out = &scratch[idx(r, 0, width)];
+        if (i < 0 || i >= state.height) {
+            for (int c = 0; c < width; c++) {
+                out[c] = 0;
+                other[idx(r, c, width)] = 0;
+            }
+            continue;
+        }
+
+        const uint64_t* row = packedRow(state, i);
+        for (int c = 0; c < width; c++) {
+            int k = k0 - 1 + c;
+            out[c] = (k >= 0 && k < state.words ? row[k] : 0);
+        }
+    }
+}
+
+/*
+ * Advance the scratch rows r0 to r1 (excluded) by one generation
+ * Words outside of the board are kept dead, the last board word is masked
+ */
+static inline void stepTile(const uint64_t* src, uint64_t* dst, int r0, int r1, int width,
+                            int firstWord, int lastWord, uint64_t lastMask,
+                            unsigned birth, unsigned survival) {
+    for (int r = r0; r < r1; r++) {
+        const uint64_t* up = &src[idx(r-1, 0, width)];
+        const uint64_t* mid = &src[idx(r, 0, width)];
+        const uint64_t* down = &src[idx(r+1, 0, width)];
+        uint64_t* out = &dst[idx(r, 0, width)];
+
+        uint64_t upP = 0, midP = 0, downP = 0;
+        uint64_t upC = up[0], midC = mid[0], downC = down[0];
+        for (int c = 0; c < width; c++) {
+            uint64_t upN = 0, midN = 0, downN = 0;
+            if (c+1 < width) {
+                upN = up[c+1];
+                midN = mid[c+1];
+                downN = down[c+1];
+            }
+
+            out[c] = lifeWordRule((upC << 1) | (upP >> 63), upC, (upC >> 1) | (upN << 63),
+                                  (midC << 1) | (midP >> 63), midC, (midC >> 1) | (midN << 63),
+                                  (downC << 1) | (downP >> 63), downC, (downC >> 1) | (downN << 63),
+                                  birth, survival);
+
+            upP = upC; midP = midC; downP = downC;
+            upC = upN; midC = midN; downC = downN;
+        }
+
+        for (int c = 0; c < firstWord; c++) {
+            out[c] = 0;
+        }
+        for (int c = lastWord + 1; c < width; c++) {
+            out[c] = 0;
+        }
+        if (lastWord < width) {
+            out[lastWord] &= lastMask;
+        }
+    }
+}
+
+/**
+ * Advance a bit-packed board by several generations in a single pass over memory
+ * Each tile is loaded with its halo into a tile-local scratch, advanced by the
+ * given number of generations (at most TEMPORAL_MAX_GENS), then written to newState
+ *
+ * After s generations the s outer cells of the scratch are wrong, as they didn't
+ * see their neighbours : a halo of T rows and 64 columns keeps the tile exact
+ */
+void calculateStateTemporal(packed_board_t state, packed_board_t newState, int generations) {
+    assert(generations >= 1 && generations <= TEMPORAL_MAX_GENS);
+
+    int T = generations;
+    int boardHeight = state.height;
+    int words = state.words;
+    int blocksI = (boardHeight + TEMPORAL_ROWS - 1) / TEMPORAL_ROWS;
+    int blocksJ = (words + TEMPORAL_WORDS - 1) / TEMPORAL_WORDS;
+    int height = TEMPORAL_ROWS + 2*T;
+    int width = TEMPORAL_WORDS + 2;
+    uint64_t lastMask = (state.width % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (state.width % 64)) - 1);
+    rule_t rule = getRule();
+
+    #pragma omp parallel
+    {
+        uint64_t* curr = malloc(sizeof(uint64_t) * height * width);
+        uint64_t* next = malloc(sizeof(uint64_t) * height * width);
+        assert(curr != NULL && next != NULL);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int b = 0; b < blocksI * blocksJ; b++) {
+            int i0 = (b / blocksJ) * TEMPORAL_ROWS;
+            int k0 = (b % blocksJ) * TEMPORAL_WORDS;
+            int rows = (i0 + TEMPORAL_ROWS < boardHeight ? TEMPORAL_ROWS : boardHeight - i0);
+            int cols = (k0 + TEMPORAL_WORDS < words ? TEMPORAL_WORDS : words - k0);
+
+            // Scratch rows and words which are inside the board
+            int rowsIn0 = (i0 - T < 0 ? T - i0 : 0);
+            int rowsIn1 = (i0 + rows + T > boardHeight ? T + boardHeight - i0 : rows + 2*T);
+            int firstWord = (k0 == 0 ? 1 : 0);
+            int lastWord = words - k0;
+
+            loadTile(state, curr, next, i0, k0, rows + 2*T, width, T);
+            for (int s = 1; s <= T; s++) {
+                int r0 = (s > rowsIn0 ? s : rowsIn0);
+                int r1 = (rows + 2*T - s < rowsIn1 ? rows + 2*T - s : rowsIn1);
+                #define TEMPORAL_STEP(B, S) stepTile(curr, next, r0, r1, width, firstWord, lastWord, lastMask, B, S)
+                RULE_SPECIALIZE(rule, TEMPORAL_STEP);
+                #undef TEMPORAL_STEP
+
+                uint64_t* tmp = curr;
+                curr = next;
+                next = tmp;
+            }
+
+            for (int r = 0; r < rows; r++) {
+                uint64_t* out = packedRow(newState, i0 + r);
+                for (int c = 0; c < cols; c++) {
+                    out[k0 + c] = curr[idx(T + r, 1 + c, width)];
+                }
+            }
+        }
+
+        free(curr);
+        free(next);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Title    : Game of life / temporal
+ * Desc     : Headers for the temporally blocked engine
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _TEMPORAL_H_
+#define _TEMPORAL_H_
+
+#include "board.h"
+
+/*
+ * Tile advanced in the scratch buffers, in rows and 64-bit words
+ * A halo of T rows and one word on each side is loaded with it
+ */
+#define TEMPORAL_ROWS 256
+#define TEMPORAL_WORDS 32
+#define TEMPORAL_DEFAULT_GENS 8
+#define TEMPORAL_MAX_GENS 64
+
+/**
+ * Advance a bit-packed board by several generations in a single pass over memory
+ * Each tile is loaded with its halo into a tile-local scratch, advanced by the
+ * given number of generations (at most TEMPORAL_MAX_GENS), then written to newState
+ */
+void calculateStateTemporal(packed_board_t state, packed_board_t newState, int generations);
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Title    : Game of life / tiles
+ * Desc     : Active tiles engine, quiescent tiles are skipped
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "automata.h"
+#include "tiles.h"
+#include "boundary.h"
+#include "math.h"
+
+/**
+ * Alocate a tiled board of width x height cells
+ */
+tiles_t allocTiles(int width, int height) {
+    tiles_t tiles;
+    tiles.curr = allocPackedBoard(width, height);
+    tiles.next = allocPackedBoard(width, height);
+    tiles.rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.cols = tiles.curr.words;
+    tiles.flags = calloc(sizeof(char), (size_t)tiles.rows * tiles.cols);
+    tiles.nextFlags = calloc(sizeof(char), (size_t)tiles.rows * tiles.cols);
+    tiles.active = calloc(sizeof(char), (size_t)tiles.rows * tiles.cols);
+    assert(tiles.flags != NULL && tiles.nextFlags != NULL && tiles.active != NULL);
+    tiles.warmup = 1;
+    tiles.total = 0;
+    tiles.skipped = 0;
+
+    return tiles;
+}
+
+/**
+ * Free memory of a tiled board
+ */
+void freeTiles(tiles_t tiles) {
+    freePackedBoard(tiles.curr);
+    freePackedBoard(tiles.next);
+    free(tiles.flags);
+    free(tiles.nextFlags);
+    free(tiles.active);
+}
+
+/**
+ * Load a board in the tiles, every tile is computed during the next 2 generations
+ */
+void packTiles(tiles_t* tiles, board_t board) {
+    packBoard(board, tiles->curr);
+    memset(tiles->flags, TILE_CHANGED | TILE_UNSTABLE, (size_t)tiles->rows * tiles->cols);
+    tiles->warmup = 1;
+}
+
+/**
+ * Write the tiles content to a board
+ */
+void unpackTiles(tiles_t tiles, board_t board) {
+    unpackBoard(tiles.curr, board);
+}
+
+/*
+ * Return 1 if the tile or one of its 8 neighbours is unstable
+ * The tiles along the edges see the halo, they are always computed unless the boundary is dead
+ */
+static inline int tileActive(tiles_t* tiles, int ti, int tj, int boundary) {
+    if (boundary != BOUNDARY_DEAD && (ti == 0 || tj == 0 || ti == tiles->rows-1 || tj == tiles->cols-1)) {
+        return 1;
+    }
+    for (int i = max(ti-1, 0); i <= min(ti+1, tiles->rows-1); i++) {
+        for (int j = max(tj-1, 0); j <= min(tj+1, tiles->cols-1); j++) {
+            if (tiles->flags[idx(i, j, tiles->cols)] & TILE_UNSTABLE) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Calculate the next state, only the tiles which changed or have a changed
+ * neighbour are computed, the other ones are known to stay the same
+ * Period 2 oscillators (blinkers) are skipped as well as still lifes
+ *
+ * The next buffer holds the generation g-1. When a tile and its neighbours are
+ * the same at g and g-2, the tile at g+1 is the same as at g-1 : it is already
+ * in the next buffer and keeps its changed flag
+ * The tiles are computed one band of rows at a time to keep the rows streaming
+ */
+void calculateStateTiles(tiles_t* tiles) {
+    int count = tiles->rows * tiles->cols;
+    int boundary = getBoundary();
+    long long skipped = 0;
+    fillPackedHalo(tiles->curr);
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:skipped)
+    for (int ti = 0; ti < tiles->rows; ti++) {
+        char* active = &tiles->active[idx(ti, 0, tiles->cols)];
+        char* flags = &tiles->nextFlags[idx(ti, 0, tiles->cols)];
+        int any = 0;
+
+        for (int tj = 0; tj < tiles->cols; tj++) {
+            active[tj] = tileActive(tiles, ti, tj, boundary);
+            flags[tj] = (active[tj] ? 0 : tiles->flags[idx(ti, tj, tiles->cols)] & TILE_CHANGED);
+            skipped += !active[tj];
+            any |= active[tj];
+        }
+
+        if (any) {
+            int i0 = ti * TILE_SIZE;
+            int i1 = min(i0 + TILE_SIZE, tiles->curr.height);
+            calculateBandPacked(tiles->curr, tiles->next, i0, i1, active, flags);
+        }
+    }
+
+    packed_board_t tmp = tiles->curr;
+    tiles->curr = tiles->next;
+    tiles->next = tmp;
+    char* tmpFlags = tiles->flags;
+    tiles->flags = tiles->nextFlags;
+    tiles->nextFlags = tmpFlags;
+
+    if (tiles->warmup) {
+        // The next buffer didn't hold a real previous generation
+        memset(tiles->flags, TILE_CHANGED | TILE_UNSTABLE, count);
+        tiles->warmup = 0;
+    }
+    tiles->total += count;
+    tiles->skipped += skipped;
+}
+
+/**
+ * Return 1 if the tile (ti, tj) changed during the last generation
+ */
+int tileChanged(tiles_t tiles, int ti, int tj) {
+    return (tiles.flags[idx(ti, tj, tiles.cols)] & TILE_CHANGED) != 0;
+}
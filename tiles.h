@@ -0,0 +1,86 @@
+/*
+ * Title    : Game of life / tiles
+ * Desc     : Headers for the active tiles engine
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _TILES_H_
+#define _TILES_H_
+
+#include "board.h"
+
+/*
+ * A tile is 64 rows of a single 64-bit word of a bit-packed board (64x64 cells)
+ */
+#define TILE_SIZE 64
+
+/*
+ * changed : the tile differs from the previous generation
+ * unstable : the tile differs from two generations ago
+ * warmup : set after a load, the flags of the next generation can't be trusted
+ */
+typedef struct tiles {
+    packed_board_t curr;
+    packed_board_t next;
+    char* flags;
+    char* nextFlags;
+    char* active;
+    int rows;
+    int cols;
+    int warmup;
+    long long total;
+    long long skipped;
+} tiles_t;
+
+/**
+ * Alocate a tiled board of width x height cells
+ */
+tiles_t allocTiles(int width, int height);
+/**
+ * Free memory of a tiled board
+ */
+void freeTiles(tiles_t tiles);
+/**
+ * Load a board in the tiles, every tile is computed during the next 2 generations
+ */
+void packTiles(tiles_t* tiles, board_t board);
+/**
+ * Write the tiles content to a board
+ */
+void unpackTiles(tiles_t tiles, board_t board);
+/**
+ * Calculate the next state, only the tiles which changed or have a changed
+ * neighbour are computed, the other ones are known to stay the same
+ * Period 2 oscillators (blinkers) are skipped as well as still lifes
+ */
+void calculateStateTiles(tiles_t* tiles);
+/**
+ * Return 1 if the tile (ti, tj) changed during the last generation
+ */
+int tileChanged(tiles_t tiles, int ti, int tj);
+
+#endif
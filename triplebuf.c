@@ -0,0 +1,105 @@
+/*
+ * Title    : Game of life / triplebuf
+ * Desc     : Lock-free triple buffer of frames between the simulation and the display
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "triplebuf.h"
+
+#define FRAME_FRESH 4
+#define FRAME_INDEX 3
+
+/*
+ * Alocate the three frames of width x height pixels
+ */
+triple_buffer_t* tripleCreate(int width, int height) {
+    triple_buffer_t* buffer = malloc(sizeof(triple_buffer_t));
+    assert(buffer != NULL);
+
+    for (int k = 0; k < 3; k++) {
+        buffer->frames[k].pixels = calloc(1, (size_t)width * height);
+        buffer->frames[k].lines = calloc(1, height);
+        assert(buffer->frames[k].pixels != NULL && buffer->frames[k].lines != NULL);
+        buffer->frames[k].generation = 0;
+        buffer->frames[k].sequence = 0;
+    }
+    buffer->front = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->back = 2;
+
+    return buffer;
+}
+
+/*
+ * Free the three frames
+ */
+void tripleFree(triple_buffer_t* buffer) {
+    for (int k = 0; k < 3; k++) {
+        free(buffer->frames[k].pixels);
+        free(buffer->frames[k].lines);
+    }
+    free(buffer);
+}
+
+/*
+ * Return the frame to fill by the producer
+ */
+frame_t* tripleBack(triple_buffer_t* buffer) {
+    return &buffer->frames[buffer->back];
+}
+
+/*
+ * Publish the back frame, the producer gets a new back frame
+ * Release ordering makes the frame content visible before its index
+ */
+void triplePublish(triple_buffer_t* buffer) {
+    int old = atomic_exchange_explicit(&buffer->middle, buffer->back | FRAME_FRESH, memory_order_acq_rel);
+    buffer->back = old & FRAME_INDEX;
+}
+
+/*
+ * Take the newest published frame if there is one, return 0 otherwise
+ * The front frame stays valid until the next call
+ */
+int tripleUpdate(triple_buffer_t* buffer) {
+    if (!(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & FRAME_FRESH)) {
+        return 0;
+    }
+
+    int old = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+    buffer->front = old & FRAME_INDEX;
+    return 1;
+}
+
+/*
+ * Return the frame read by the consumer
+ */
+frame_t* tripleFront(triple_buffer_t* buffer) {
+    return &buffer->frames[buffer->front];
+}
@@ -0,0 +1,94 @@
+/*
+ * Title    : Game of life / triplebuf
+ * Desc     : Headers for the lock-free triple buffer of frames
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _TRIPLEBUF_H_
+#define _TRIPLEBUF_H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * A completed generation, rendered as the pixels of the view
+ * lines flags the lines of pixels which changed since the frame published
+ * just before, sequence numbers the published frames from 1
+ */
+typedef struct frame {
+    unsigned char* pixels;
+    unsigned char* lines;
+    long long generation;
+    long long sequence;
+} frame_t;
+
+/*
+ * Lock-free triple buffer between one producer and one consumer
+ * The producer writes the back frame while the consumer reads the front one,
+ * the middle one is exchanged atomically, with FRAME_FRESH set when it holds a
+ * frame the consumer has not taken yet. Unread frames are overwritten, so the
+ * consumer always gets the newest one
+ */
+typedef struct triple_buffer {
+    frame_t frames[3];
+    atomic_int middle;
+    int back;
+    int front;
+} triple_buffer_t;
+
+/*
+ * Alocate the three frames of width x height pixels
+ */
+triple_buffer_t* tripleCreate(int width, int height);
+
+/*
+ * Free the three frames
+ */
+void tripleFree(triple_buffer_t* buffer);
+
+/*
+ * Return the frame to fill by the producer
+ */
+frame_t* tripleBack(triple_buffer_t* buffer);
+
+/*
+ * Publish the back frame, the producer gets a new back frame
+ */
+void triplePublish(triple_buffer_t* buffer);
+
+/*
+ * Take the newest published frame if there is one, return 0 otherwise
+ * The front frame stays valid until the next call
+ */
+int tripleUpdate(triple_buffer_t* buffer);
+
+/*
+ * Return the frame read by the consumer
+ */
+frame_t* tripleFront(triple_buffer_t* buffer);
+
+#endif
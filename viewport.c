@@ -0,0 +1,371 @@
+/*
+ * Title    : Game of life / viewport
+ * Desc     : Viewport rendering : visible cells when zoomed in, density map when zoomed out
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "board.h"
+#include "viewport.h"
+#include "math.h"
+
+#define VIEW_GRAY_EMPTY 235
+#define VIEW_GRAY_CELL 20
+#define VIEW_GRAY_BACK 200
+
+/*
+ * Alocate the density map of a board of width x height cells, every tile dirty
+ */
+density_t allocDensity(int width, int height) {
+    density_t density;
+    density.rows = (height + VIEW_TILE - 1) / VIEW_TILE;
+    density.cols = (width + VIEW_TILE - 1) / VIEW_TILE;
+    density.counts = calloc(sizeof(uint16_t), (size_t)density.rows * density.cols);
+    density.dirty = malloc((size_t)density.rows * density.cols);
+    assert(density.counts != NULL && density.dirty != NULL);
+    densityDirtyAll(&density);
+
+    return density;
+}
+
+/*
+ * Free memory of a density map
+ */
+void freeDensity(density_t density) {
+    free(density.counts);
+    free(density.dirty);
+}
+
+/*
+ * Mark a tile to be counted again
+ */
+void densityDirtyTile(density_t* density, int ti, int tj) {
+    density->dirty[idx(ti, tj, density->cols)] = 1;
+}
+
+/*
+ * Mark every tile to be counted again
+ */
+void densityDirtyAll(density_t* density) {
+    memset(density->dirty, 1, (size_t)density->rows * density->cols);
+}
+
+/*
+ * Count the living cells of the dirty tiles, a tile is one word wide
+ */
+static void countDensity(density_t* density, packed_board_t board) {
+    assert(VIEW_TILE == 64 && density->cols == board.words);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int ti = 0; ti < density->rows; ti++) {
+        int i1 = min((ti + 1) * VIEW_TILE, board.height);
+        for (int tj = 0; tj < density->cols; tj++) {
+            size_t t = idx(ti, tj, density->cols);
+            if (density->dirty[t]) {
+                int count = 0;
+                for (int i = ti * VIEW_TILE; i < i1; i++) {
+                    count += __builtin_popcountll(packedRow(board, i)[tj]);
+                }
+                density->counts[t] = count;
+                density->dirty[t] = 0;
+            }
+        }
+    }
+}
+
+/*
+ * Return the number of cells shown on the given pixels of the view
+ */
+int viewCells(view_t view, int pixels) {
+    if (view.zoom > 0) {
+        return (pixels + view.zoom - 1) / view.zoom;
+    }
+    return pixels * -view.zoom;
+}
+
+/*
+ * Set the flags of the lines of the view that show a cell of the tile (ti, tj)
+ * of VIEW_TILE x VIEW_TILE cells
+ */
+void viewDirtyTile(view_t view, int ti, int tj, unsigned char* lines) {
+    int j0 = tj * VIEW_TILE - view.j0;
+    int i0 = max(ti * VIEW_TILE - view.i0, 0);
+    int i1 = ti * VIEW_TILE + VIEW_TILE - view.i0;
+    if (j0 + VIEW_TILE <= 0 || j0 >= viewCells(view, view.width) || i1 <= i0) {
+        return;
+    }
+
+    int y0 = (view.zoom > 0 ? i0 * view.zoom : i0 / -view.zoom);
+    int y1 = (view.zoom > 0 ? i1 * view.zoom : (i1 - 1) / -view.zoom + 1);
+    y1 = min(y1, view.height);
+    if (y0 < y1) {
+        memset(&lines[y0], 1, y1 - y0);
+    }
+}
+
+/*
+ * Keep the view on the board, aligned on its cells per pixel
+ */
+static view_t clampView(view_t view, int width, int height) {
+    view.i0 = min(max(view.i0, 0), max(height - viewCells(view, view.height), 0));
+    view.j0 = min(max(view.j0, 0), max(width - viewCells(view, view.width), 0));
+    if (view.zoom < 0) {
+        view.i0 -= view.i0 % -view.zoom;
+        view.j0 -= view.j0 % -view.zoom;
+    }
+    return view;
+}
+
+/*
+ * Return a view of a board of width x height cells zoomed in (in = 1) or out
+ * (in = 0) around the pixel (x, y) of the view, the cell under it stays in place
+ */
+view_t zoomView(view_t view, int width, int height, int in, int x, int y) {
+    double scale = (view.zoom > 0 ? 1.0 / view.zoom : -view.zoom);
+    double fi = view.i0 + y * scale;
+    double fj = view.j0 + x * scale;
+
+    if (in) {
+        if (view.zoom > 0) {
+            view.zoom = min(view.zoom * 2, VIEW_MAX_ZOOM);
+        } else {
+            view.zoom = (view.zoom == -2 ? 1 : view.zoom / 2);
+        }
+    } else if (viewCells(view, view.width) < width || viewCells(view, view.height) < height) {
+        // No need to zoom out once the whole board is visible
+        if (view.zoom > 1) {
+            view.zoom /= 2;
+        } else {
+            view.zoom = (view.zoom == 1 ? -2 : view.zoom * 2);
+        }
+    }
+
+    scale = (view.zoom > 0 ? 1.0 / view.zoom : -view.zoom);
+    view.i0 = (int)(fi - y * scale + 0.5);
+    view.j0 = (int)(fj - x * scale + 0.5);
+    return clampView(view, width, height);
+}
+
+/*
+ * Return a view of a board of width x height cells moved by (di, dj) quarters
+ * of the view
+ */
+view_t panView(view_t view, int width, int height, int di, int dj) {
+    view.i0 += di * max(viewCells(view, view.height) / 4, 1);
+    view.j0 += dj * max(viewCells(view, view.width) / 4, 1);
+    if (view.zoom < 0) {
+        // Round towards the move, so small steps are not lost by the alignment
+        view.i0 += (di > 0 ? -view.zoom - 1 : 0);
+        view.j0 += (dj > 0 ? -view.zoom - 1 : 0);
+    }
+    return clampView(view, width, height);
+}
+
+/*
+ * Return the view of a whole board of width x height cells within a square of
+ * the given pixels, with zoom pixels per cell if it fits
+ * The short side of a strip keeps VIEW_MIN_PIXELS, so it can still be zoomed
+ */
+view_t fitView(int width, int height, int pixels, int zoom) {
+    int size = max(width, height);
+    view_t view = { pixels, pixels, zoom, 0, 0 };
+    if (size * zoom > pixels) {
+        view.zoom = pixels / size;
+    }
+    if (view.zoom > 0) {
+        view.width = width * view.zoom;
+        view.height = height * view.zoom;
+    } else {
+        view.zoom = -2;
+        while ((size - view.zoom - 1) / -view.zoom > pixels) {
+            view.zoom *= 2;
+        }
+        view.width = (width - view.zoom - 1) / -view.zoom;
+        view.height = (height - view.zoom - 1) / -view.zoom;
+    }
+
+    view.width = max(view.width, min(VIEW_MIN_PIXELS, view.height));
+    view.height = max(view.height, min(VIEW_MIN_PIXELS, view.width));
+    return view;
+}
+
+/*
+ * Return the gray level of a value of the view, from light (dead) to dark
+ * (alive), the background is a middle gray
+ */
+int viewGray(int value) {
+    if (value == VIEW_BACK) {
+        return VIEW_GRAY_BACK;
+    }
+    return VIEW_GRAY_EMPTY - value * (VIEW_GRAY_EMPTY - VIEW_GRAY_CELL) / VIEW_FULL;
+}
+
+/*
+ * Zoomed in : each visible cell is drawn on zoom x zoom pixels
+ */
+static void renderCells(view_t view, packed_board_t board, unsigned char* pixels) {
+    int p = view.zoom;
+    int margin = (p >= 3);
+    int rows = viewCells(view, view.height);
+    int cols = viewCells(view, view.width);
+
+    #pragma omp parallel for
+    for (int r = 0; r < rows; r++) {
+        int y0 = r * p;
+        unsigned char* line = &pixels[(size_t)y0 * view.width];
+        int i = view.i0 + r;
+
+        for (int c = 0; c < cols; c++) {
+            int j = view.j0 + c;
+            int value = VIEW_BACK;
+            if (i < board.height && j < board.width) {
+                value = ((packedRow(board, i)[j / 64] >> (j % 64)) & 1 ? VIEW_FULL : 0);
+            }
+            int x0 = c * p;
+            int x1 = min(x0 + p - margin, view.width);
+            memset(&line[x0], value, x1 - x0);
+            if (margin && x1 < view.width) {
+                line[x1] = VIEW_BACK;
+            }
+        }
+
+        int y1 = min(y0 + p, view.height);
+        for (int y = y0 + 1; y < y1; y++) {
+            if (margin && y == y0 + p - 1) {
+                memset(&pixels[(size_t)y * view.width], VIEW_BACK, view.width);
+            } else {
+                memcpy(&pixels[(size_t)y * view.width], line, view.width);
+            }
+        }
+    }
+}
+
+/*
+ * Convert a number of living cells to a density, a single cell stays visible
+ */
+static inline int densityValue(long count, long area) {
+    return (count == 0 ? 0 : (int)max(count * VIEW_FULL / area, 1L));
+}
+
+/*
+ * Zoomed out below a tile per pixel : the c x c cells of each pixel are counted,
+ * c bits of the packed row at once
+ */
+static void renderCounts(view_t view, packed_board_t board, unsigned char* pixels) {
+    int c = -view.zoom;
+    uint64_t mask = (1ULL << c) - 1;
+
+    #pragma omp parallel
+    {
+        int* counts = malloc(view.width * sizeof(int));
+        assert(counts != NULL);
+
+        #pragma omp for
+        for (int y = 0; y < view.height; y++) {
+            unsigned char* line = &pixels[(size_t)y * view.width];
+            int i0 = view.i0 + y * c;
+            if (i0 >= board.height) {
+                memset(line, VIEW_BACK, view.width);
+                continue;
+            }
+
+            memset(counts, 0, view.width * sizeof(int));
+            int i1 = min(i0 + c, board.height);
+            for (int i = i0; i < i1; i++) {
+                // c divides 64 and j0, so the pixels never straddle two words
+                const uint64_t* row = packedRow(board, i);
+                int x = 0;
+                for (int k = view.j0 / 64; k < board.words && x < view.width; k++) {
+                    uint64_t word = row[k] >> (x == 0 ? view.j0 % 64 : 0);
+                    for (; word != 0 && x < view.width; word >>= c) {
+                        counts[x++] += __builtin_popcountll(word & mask);
+                    }
+                    x = min(((k + 1) * 64 - view.j0) / c, view.width);
+                }
+            }
+
+            for (int x = 0; x < view.width; x++) {
+                int j = view.j0 + x * c;
+                line[x] = (j < board.width ? densityValue(counts[x], (long)c * c) : VIEW_BACK);
+            }
+        }
+
+        free(counts);
+    }
+}
+
+/*
+ * Zoomed out by a tile per pixel or more : the density map is summed, the
+ * board itself is only read for the dirty tiles
+ */
+static void renderDensity(view_t view, packed_board_t board, density_t* density, unsigned char* pixels) {
+    int c = -view.zoom;
+    int n = c / VIEW_TILE;
+    countDensity(density, board);
+
+    #pragma omp parallel for
+    for (int y = 0; y < view.height; y++) {
+        unsigned char* line = &pixels[(size_t)y * view.width];
+        int ti0 = (view.i0 + y * c) / VIEW_TILE;
+        int ti1 = min(ti0 + n, density->rows);
+
+        for (int x = 0; x < view.width; x++) {
+            int tj0 = (view.j0 + x * c) / VIEW_TILE;
+            int tj1 = min(tj0 + n, density->cols);
+            if (ti0 >= ti1 || tj0 >= tj1) {
+                line[x] = VIEW_BACK;
+                continue;
+            }
+
+            long count = 0;
+            for (int ti = ti0; ti < ti1; ti++) {
+                for (int tj = tj0; tj < tj1; tj++) {
+                    count += density->counts[idx(ti, tj, density->cols)];
+                }
+            }
+            line[x] = densityValue(count, (long)c * c);
+        }
+    }
+}
+
+/*
+ * Draw the view of the board in pixels (view.width x view.height)
+ * Cells are 0 (dead) or VIEW_FULL (alive), densities in between, and
+ * VIEW_BACK is the margins and the outside of the board
+ * Only the visible cells are read, or the density map when zoomed out
+ */
+void renderView(view_t view, packed_board_t board, density_t* density, unsigned char* pixels) {
+    if (view.zoom > 0) {
+        renderCells(view, board, pixels);
+    } else if (-view.zoom < VIEW_TILE) {
+        renderCounts(view, board, pixels);
+    } else {
+        renderDensity(view, board, density, pixels);
+    }
+}
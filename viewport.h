@@ -0,0 +1,135 @@
+/*
+ * Title    : Game of life / viewport
+ * Desc     : Headers for the viewport rendering, zoom and density maps
+ * Author   : Joël von der Weid - HEPIA ISC
+ * Date     : August 2022
+ * Version  : 0.5
+  
+MIT License
+
+Copyright (c) 2018-2022 VON DER WEID Joël
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _VIEWPORT_H_
+#define _VIEWPORT_H_
+
+#include <stdint.h>
+#include "board.h"
+
+#define VIEW_TILE 64
+#define VIEW_FULL 254
+#define VIEW_BACK 255
+#define VIEW_MAX_ZOOM 32
+#define VIEW_MIN_PIXELS 64
+
+/*
+ * Part of the board shown on (width x height) pixels, from the cell (i0, j0)
+ * zoom > 0 : zoom pixels per cell, the last line and column of a cell are
+ *            a margin when zoom >= 3
+ * zoom < 0 : -zoom cells per pixel (a power of 2), i0 and j0 are multiples
+ *            of it so each pixel covers whole words of the packed rows
+ */
+typedef struct view {
+    int width;
+    int height;
+    int zoom;
+    int i0;
+    int j0;
+} view_t;
+
+/*
+ * Number of living cells per tile of VIEW_TILE x VIEW_TILE cells, used by the
+ * views of VIEW_TILE cells per pixel or more. Only the dirty tiles are counted
+ * again, so the engines which know their changed tiles keep it up to date
+ * without reading the whole board
+ */
+typedef struct density {
+    uint16_t* counts;
+    char* dirty;
+    int rows;
+    int cols;
+} density_t;
+
+/*
+ * Alocate the density map of a board of width x height cells, every tile dirty
+ */
+density_t allocDensity(int width, int height);
+
+/*
+ * Free memory of a density map
+ */
+void freeDensity(density_t density);
+
+/*
+ * Mark a tile to be counted again
+ */
+void densityDirtyTile(density_t* density, int ti, int tj);
+
+/*
+ * Mark every tile to be counted again
+ */
+void densityDirtyAll(density_t* density);
+
+/*
+ * Return the number of cells shown on the given pixels of the view
+ */
+int viewCells(view_t view, int pixels);
+
+/*
+ * Set the flags of the lines of the view that show a cell of the tile (ti, tj)
+ * of VIEW_TILE x VIEW_TILE cells, one flag per line
+ */
+void viewDirtyTile(view_t view, int ti, int tj, unsigned char* lines);
+
+/*
+ * Return a view of a board of width x height cells zoomed in (in = 1) or out
+ * (in = 0) around the pixel (x, y) of the view, the cell under it stays in place
+ */
+view_t zoomView(view_t view, int width, int height, int in, int x, int y);
+
+/*
+ * Return a view of a board of width x height cells moved by (di, dj) quarters
+ * of the view
+ */
+view_t panView(view_t view, int width, int height, int di, int dj);
+
+/*
+ * Return the view of a whole board of width x height cells within a square of
+ * the given pixels, with zoom pixels per cell if it fits
+ * The short side of a strip keeps VIEW_MIN_PIXELS, so it can still be zoomed
+ */
+view_t fitView(int width, int height, int pixels, int zoom);
+
+/*
+ * Return the gray level of a value of the view, from light (dead) to dark
+ * (alive), the background is a middle gray
+ */
+int viewGray(int value);
+
+/*
+ * Draw the view of the board in pixels (view.width x view.height)
+ * Cells are 0 (dead) or VIEW_FULL (alive), densities in between, and
+ * VIEW_BACK is the margins and the outside of the board
+ * Only the visible cells are read, or the density map when zoomed out
+ */
+void renderView(view_t view, packed_board_t board, density_t* density, unsigned char* pixels);
+
+#endif